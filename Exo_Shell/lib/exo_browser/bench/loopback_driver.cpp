@@ -0,0 +1,118 @@
+// Drives WebManager against loopback_server.py and checks what went over the
+// wire, using the server's own request counts.
+//
+//   make loopback
+//   bench/loopback_driver http://127.0.0.1:PORT
+#include "../include/WebManager.h"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <sstream>
+#include <string>
+
+namespace {
+
+std::string base;
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+    std::printf("%s %s\n", ok ? "ok  " : "FAIL", what.c_str());
+    if (!ok) failures++;
+}
+
+std::shared_ptr<PageSnapshot> waitFor(WebManager& web, std::shared_ptr<PageSnapshot> page) {
+    while (page->loading) web.poll(-1);
+    return page;
+}
+
+bool shows(const std::shared_ptr<PageSnapshot>& page, const std::string& text) {
+    return page->document->getText().find(text) != std::string::npos;
+}
+
+// One line of /stats: requests for a path, or "connections"
+int stat(const std::string& key) {
+    HttpClient http;
+    std::string body;
+    bool done = false;
+    http.fetch(
+        base + "/stats", [&](std::string_view chunk) { body.append(chunk); },
+        [&](HttpResponse&) { done = true; });
+    while (!done) http.run(-1);
+
+    std::istringstream lines(body);
+    std::string name;
+    int count;
+    while (lines >> name >> count) {
+        if (name == key) return count;
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::fprintf(stderr, "usage: %s http://127.0.0.1:PORT\n", argv[0]);
+        return 2;
+    }
+    base = argv[1];
+    std::filesystem::path cacheDir = std::filesystem::temp_directory_path() / "exo_loopback_cache";
+    std::filesystem::remove_all(cacheDir);
+    std::filesystem::create_directories(cacheDir);
+
+    {
+        WebManager web;
+        web.enableDiskCache(cacheDir.string());
+
+        auto page = waitFor(web, web.fetchPage(base + "/redirect"));
+        check(page->url == base + "/cached/page" && shows(page, "Page /cached/page"), "redirect is followed");
+
+        page = waitFor(web, web.fetchPage(base + "/chunked"));
+        check(shows(page, "part0 part1") && shows(page, "part38 part39"), "chunked body is reassembled");
+
+        page = web.fetchPage(base + "/redirect");
+        check(!page->loading && stat("/redirect") == 1, "max-age page is reused from memory");
+
+        page = waitFor(web, web.fetchPage(base + "/plain/a"));
+        page = waitFor(web, web.fetchPage(base + "/plain/a"));
+        check(stat("/plain/a") == 2, "page without freshness is refetched");
+
+        // History is restored from the cached snapshots, stale or not
+        auto pageA = page;
+        auto pageB = waitFor(web, web.fetchPage(base + "/plain/b"));
+        int requests = stat("/plain/a") + stat("/plain/b");
+        page = web.goBack();
+        check(page == pageA && !page->loading && shows(page, "Page /plain/a"), "back shows the earlier snapshot");
+        page = web.goForward();
+        check(page == pageB && !page->loading && shows(page, "Page /plain/b"), "forward shows the later snapshot");
+        check(stat("/plain/a") + stat("/plain/b") == requests, "back and forward make no requests");
+
+        check(stat("connections") == 1, "one keep-alive connection carried every request");
+    }
+
+    {
+        WebManager web;
+        web.enableDiskCache(cacheDir.string());
+        auto page = web.fetchPage(base + "/redirect");
+        check(!page->loading && shows(page, "Page /cached/page") && stat("/redirect") == 1,
+              "max-age page is reused from disk by a new session");
+    }
+
+    {
+        WebManager web;
+        waitFor(web, web.fetchPage(base + "/plain/l1"));
+        waitFor(web, web.fetchPage(base + "/links"));
+        for (int i = 0; i < 20; ++i) web.poll(50); // let the link prefetches finish
+        check(stat("/plain/l0") == 1, "links of the page are prefetched");
+        check(stat("/plain/l1") == 2, "stale cached link is prefetched again");
+
+        auto page = web.fetchPage(base + "/plain/l1");
+        check(!page->loading && shows(page, "Page /plain/l1") && stat("/plain/l1") == 2,
+              "prefetched page is adopted by the navigation");
+        page = web.fetchPage(base + "/plain/l0");
+        check(!page->loading && stat("/plain/l0") == 1, "prefetched page is adopted after another navigation");
+    }
+
+    std::filesystem::remove_all(cacheDir);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+# Stand-in web server for loopback_driver: python3 loopback_server.py PORT
+#
+#   /redirect     302 to /cached/page
+#   /cached/*     Cache-Control: max-age=100
+#   /chunked      chunked body, sent a few bytes per chunk
+#   /plain/*      no freshness information, must be refetched
+#   /links        chunked page linking to /plain/l0 .. /plain/l5, sent slowly
+#   /stats        requests per path and connections used, not counted itself
+import http.server
+import sys
+import threading
+import time
+
+lock = threading.Lock()
+hits = {}
+connections = set()
+
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+
+    def log_message(self, *args):
+        pass
+
+    def send_body(self, body, headers=()):
+        self.send_response(200)
+        for name, value in headers:
+            self.send_header(name, value)
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def send_chunked(self, parts, delay=0):
+        self.send_response(200)
+        self.send_header("Transfer-Encoding", "chunked")
+        self.end_headers()
+        for part in parts:
+            self.wfile.write(b"%x\r\n%s\r\n" % (len(part), part))
+            self.wfile.flush()
+            time.sleep(delay)
+        self.wfile.write(b"0\r\n\r\n")
+
+    def do_GET(self):
+        if self.path == "/stats":
+            with lock:
+                lines = ["%s %d" % item for item in sorted(hits.items())]
+                lines.append("connections %d" % len(connections))
+            self.send_body(("\n".join(lines) + "\n").encode(), [("Cache-Control", "no-store")])
+            return
+        with lock:
+            hits[self.path] = hits.get(self.path, 0) + 1
+            connections.add(self.client_address)
+
+        page = ("<html><body><p>Page %s</p></body></html>" % self.path).encode()
+        if self.path == "/redirect":
+            self.send_response(302)
+            self.send_header("Location", "/cached/page")
+            self.send_header("Content-Length", "0")
+            self.end_headers()
+        elif self.path.startswith("/cached/"):
+            self.send_body(page, [("Cache-Control", "max-age=100")])
+        elif self.path == "/chunked":
+            body = b"<html><body><p>" + b" ".join(b"part%d" % i for i in range(40)) + b"</p></body></html>"
+            self.send_chunked([body[i:i + 7] for i in range(0, len(body), 7)])
+        elif self.path == "/links":
+            links = "".join("<p><a href='/plain/l%d'>link %d</a></p>" % (i, i) for i in range(6))
+            parts = [("<html><body>" + links).encode()]
+            parts += [("<p>para %d</p>\n" % i).encode() for i in range(3)]
+            self.send_chunked(parts + [b"</body></html>"], 0.1)
+        elif self.path.startswith("/plain/"):
+            self.send_body(page)
+        else:
+            self.send_error(404)
+
+
+http.server.ThreadingHTTPServer(("127.0.0.1", int(sys.argv[1])), Handler).serve_forever()
@@ -0,0 +1,120 @@
+// Times HTMLParser on multi-MB pages fed in network-sized chunks.
+//
+//   make bench
+//   bench/parse_bench [-m megabytes] [-c chunk bytes] fixture.html...
+//
+// Each saved fixture is repeated up to the requested size and parsed three
+// ways: as is, opening with a tag whose quoted value never closes, and
+// opening with a comment that never closes. The last two are the worst case
+// for a streaming tokenizer, which has to carry the whole page over from
+// chunk to chunk. Every run is also checked against a single-feed parse.
+#include "../include/HTMLParser.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Result {
+    double ms;
+    size_t links;
+    size_t textBytes;
+    bool matches;
+};
+
+bool readFile(const char* path, std::string& contents) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    contents = buffer.str();
+    return true;
+}
+
+std::string repeatTo(const std::string& page, size_t size) {
+    std::string out;
+    out.reserve(size + page.size());
+    while (out.size() < size) out += page;
+    return out;
+}
+
+Result parse(const std::string& html, size_t chunkSize) {
+    auto start = std::chrono::steady_clock::now();
+    HTMLParser parser;
+    for (size_t i = 0; i < html.size(); i += chunkSize) {
+        parser.feed(std::string_view(html).substr(i, chunkSize));
+    }
+    parser.finish();
+    auto stop = std::chrono::steady_clock::now();
+
+    HTMLParser whole(html);
+    Result result;
+    result.ms = std::chrono::duration<double, std::milli>(stop - start).count();
+    result.links = parser.links().size();
+    result.textBytes = parser.getText().size();
+    result.matches = parser.getText() == whole.getText() && parser.getLinks() == whole.getLinks();
+    return result;
+}
+
+void report(const char* fixture, const char* variant, const std::string& html, size_t chunkSize, bool& ok) {
+    // Best of three, the first run also pays for faulting the pages in
+    Result best = parse(html, chunkSize);
+    for (int run = 0; run < 2; ++run) {
+        Result result = parse(html, chunkSize);
+        if (result.ms < best.ms) best = result;
+    }
+    std::printf("%-24s %-14s %8.2f MB %6zu B chunks %9.1f ms %8.1f MB/s %7zu links %s\n", fixture, variant,
+                html.size() / 1e6, chunkSize, best.ms, html.size() / 1e3 / best.ms, best.links,
+                best.matches ? "" : "MISMATCH");
+    ok = ok && best.matches;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t megabytes = 6;
+    size_t chunkSize = 4096;
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-'; ++i) {
+        if (i + 1 < argc && std::strcmp(argv[i], "-m") == 0) {
+            megabytes = std::strtoul(argv[++i], nullptr, 10);
+        } else if (i + 1 < argc && std::strcmp(argv[i], "-c") == 0) {
+            chunkSize = std::max<size_t>(1, std::strtoul(argv[++i], nullptr, 10));
+        } else {
+            break;
+        }
+    }
+    if (i == argc) {
+        std::fprintf(stderr, "usage: %s [-m megabytes] [-c chunk bytes] fixture.html...\n", argv[0]);
+        return 2;
+    }
+
+    bool ok = true;
+    for (; i < argc; ++i) {
+        std::string page;
+        if (!readFile(argv[i], page)) {
+            std::fprintf(stderr, "%s: cannot read %s\n", argv[0], argv[i]);
+            return 2;
+        }
+        const char* name = std::strrchr(argv[i], '/') ? std::strrchr(argv[i], '/') + 1 : argv[i];
+        std::string html = repeatTo(page, megabytes * 1000 * 1000);
+        report(name, "as is", html, chunkSize, ok);
+
+        // No '"' may close the value early, so the rest of the page uses '\''
+        std::string quoted = html;
+        std::replace(quoted.begin(), quoted.end(), '"', '\'');
+        report(name, "unclosed quote", "<p title=\"" + quoted, chunkSize, ok);
+
+        // Likewise no "-->", but plenty of '>' for the comment scan to stop at
+        std::string commented = html;
+        for (size_t at = 0; (at = commented.find("-->", at)) != std::string::npos;) commented[at++] = ' ';
+        report(name, "unclosed <!--", "<!--" + commented, chunkSize, ok);
+    }
+    return ok ? 0 : 1;
+}
@@ -3,24 +3,38 @@
 #include "include/HTMLParser.h"
 #include "include/UserInterface.h"
 #include <ncurses.h>  // For terminal input handling
+#include <cstdlib>
+#include <sys/stat.h>
+#include <unistd.h>
 
-int main() {
+int main(int argc, char* argv[]) {
     WebManager webManager;
-    std::string initialPage = webManager.fetchPage("http://startpage.com");
 
-    HTMLParser parser(initialPage);
-    std::vector<std::string> links = parser.getLinks();
+    // Pages that declare a freshness lifetime are kept next to the shell history
+    if (const char* home = std::getenv("HOME")) {
+        std::string cacheDir = std::string(home) + "/exo_bin/.exo_cache";
+        mkdir(cacheDir.c_str(), 0700);
+        webManager.enableDiskCache(cacheDir);
+    }
+
+    std::string startURL = argc > 1 ? argv[1] : "LandingPage.html";
+    std::shared_ptr<PageSnapshot> initialPage = webManager.fetchPage(startURL);
 
-    PageRenderer renderer(webManager);
+    PageRenderer renderer(webManager);  // owns ncurses mode until it goes out of scope
     renderer.renderPage(initialPage);
 
-    UserInterface ui(renderer);
+    UserInterface ui(renderer, webManager);
+
+    // Network and keyboard share one loop: wait for either, draw whatever
+    // arrived, then drain the pending keys without blocking
+    nodelay(stdscr, TRUE);
+    while (true) {
+        if (webManager.poll(-1, STDIN_FILENO)) renderer.update();
 
-    char input;
-    while ((input = getch()) != 'q') {
-        ui.processInput(input);
+        int input;
+        while ((input = getch()) != ERR) {
+            if (input == 'q') return 0;
+            ui.processInput(input);
+        }
     }
-    
-    endwin();  // End ncurses mode
-    return 0;
 }
@@ -0,0 +1,28 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Bump allocator for bytes that have to outlive a single token (link targets,
+// decoded attribute values). Nothing is freed individually; the whole arena
+// goes away with its owner.
+class Arena {
+public:
+    explicit Arena(size_t blockSize = 64 * 1024);
+
+    char* allocate(size_t size);
+    std::string_view store(std::string_view bytes);
+    size_t bytesUsed() const { return reserved; }
+
+private:
+    std::vector<std::unique_ptr<char[]>> blocks;
+    size_t blockSize;
+    char* cursor = nullptr;
+    size_t remaining = 0;
+    size_t reserved = 0;
+};
+
+#endif // ARENA_H
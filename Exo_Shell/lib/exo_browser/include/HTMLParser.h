@@ -2,15 +2,54 @@
 #define HTMLPARSER_H
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include "Arena.h"
+#include "HTMLTokenizer.h"
 
+// Where the visible text of an <a> sits in getText()
+struct LinkSpan {
+    size_t start;
+    size_t end;   // std::string::npos while the <a> is still open
+    size_t link;  // index into links()
+};
+
+// Builds the browser's view of a document (links and readable text) straight
+// from the token stream. Feed it chunks as they arrive, then call finish().
 class HTMLParser {
 public:
+    HTMLParser();
     explicit HTMLParser(const std::string& html);
+    HTMLParser(const HTMLParser&) = delete;
+    HTMLParser& operator=(const HTMLParser&) = delete;
+
+    void feed(std::string_view chunk);
+    void finish();
+    bool isFinished() const { return finished; }
+
     std::vector<std::string> getLinks();
+    const std::vector<std::string_view>& links() const { return linkTargets; }
+    const std::string& getText() const { return text; }
+    const std::vector<LinkSpan>& linkSpans() const { return spans; }
+    size_t memoryUsage() const;
 
 private:
-    std::string htmlContent;
+    void handleToken(const HTMLToken& token);
+    void appendText(std::string_view chunk);
+    void breakLine();
+    void closeAnchor();
+
+    Arena arena;                              // owns the link targets
+    HTMLTokenizer tokenizer;
+    std::vector<std::string_view> linkTargets;
+    std::string text;
+    std::vector<LinkSpan> spans;
+    std::string scratch;                      // reused for entity decoding
+    bool anchorOpen = false;                  // attributes that follow belong to an <a>
+    bool spanOpen = false;                    // text is going into spans.back()
+    int preDepth = 0;
+    bool pendingSpace = false;
+    bool finished = false;
 };
 
 #endif // HTMLPARSER_H
@@ -0,0 +1,62 @@
+#ifndef HTMLTOKENIZER_H
+#define HTMLTOKENIZER_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+enum class TokenType {
+    StartTag,   // name = tag, followed by one Attribute token per attribute
+    EndTag,     // name = tag
+    Attribute,  // name = attribute, value = raw (entity-encoded) value
+    Text,       // value = text with entities already decoded
+    RawText,    // value = contents of <script>/<style>
+    Comment,
+    Doctype
+};
+
+// Views into the tokenizer's buffers; only valid for the duration of the
+// handler call. Copy anything that has to live longer.
+struct HTMLToken {
+    TokenType type;
+    std::string_view name;
+    std::string_view value;
+    bool selfClosing = false;
+};
+
+// Streaming tokenizer: feed() accepts the page in arbitrary chunks as they
+// arrive and emits tokens through the handler. Only an incomplete construct
+// at the end of a chunk (a tag, comment or entity) is carried over, along
+// with how far it was scanned, so a long one is never rescanned from '<'.
+class HTMLTokenizer {
+public:
+    using TokenHandler = std::function<void(const HTMLToken&)>;
+
+    explicit HTMLTokenizer(TokenHandler handler);
+    void feed(std::string_view chunk);
+    void finish();
+
+    // Decodes character references in an attribute value into out
+    static void decodeEntities(std::string_view raw, std::string& out);
+
+private:
+    size_t tokenize(std::string_view buffer, bool atEnd);
+    const char* parseMarkup(const char* p, const char* end, bool atEnd);
+    const char* parseTag(const char* p, const char* end, bool atEnd);
+    const char* parseEntity(const char* p, const char* end, bool atEnd);
+    const char* parseRawText(const char* p, const char* end, bool atEnd);
+    void emit(TokenType type, std::string_view name, std::string_view value, bool selfClosing = false);
+    std::string_view lowered(std::string_view name, std::string& buffer);
+
+    TokenHandler handler;
+    std::string pending;     // unconsumed tail of the previous chunk
+    size_t scanned = 0;      // bytes of the construct at pending[0] already searched
+    char openQuote = 0;      // the tag at pending[0] ended inside this quote
+    std::string tagName;     // scratch buffers reused for every token
+    std::string attrName;
+    std::string rawTextTag;  // "script" or "style" while inside one
+    char entityBuffer[4];
+};
+
+#endif // HTMLTOKENIZER_H
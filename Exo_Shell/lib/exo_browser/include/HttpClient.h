@@ -0,0 +1,111 @@
+#ifndef HTTPCLIENT_H
+#define HTTPCLIENT_H
+
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "URL.h"
+
+struct HttpResponse {
+    int status = 0;
+    std::vector<std::pair<std::string, std::string>> headers;  // names lower-cased
+    std::string body;
+    std::string url;    // final URL after redirects
+    std::string error;  // set when the request failed before a response arrived
+
+    std::string header(std::string_view name) const;
+};
+
+// Incremental HTTP/1.1 response parser: bytes can be fed in any split
+class HttpResponseParser {
+public:
+    explicit HttpResponseParser(HttpResponse& response);
+    bool feed(std::string_view data);  // false on a malformed response
+    void finishOnClose();              // the peer closed the connection
+    bool complete() const { return state == State::Done; }
+    bool keepAlive() const;            // connection can carry another request
+
+private:
+    enum class State { StatusLine, Headers, Body, ChunkSize, ChunkData, ChunkEnd, Trailers, UntilClose, Done };
+
+    bool takeLine(std::string_view& data);
+    bool headersDone();
+
+    HttpResponse& response;
+    State state = State::StatusLine;
+    std::string line;      // partial status/header/chunk-size line
+    size_t remaining = 0;
+    bool http11 = false;
+    bool closeDelimited = false;
+};
+
+// Non-blocking HTTP/1.1 client driven by run(). Bodies are streamed to the
+// data handler as they arrive; idle keep-alive connections are pooled per
+// host. Handlers may start or cancel requests.
+class HttpClient {
+public:
+    using DataHandler = std::function<void(std::string_view chunk)>;
+    using DoneHandler = std::function<void(HttpResponse& response)>;  // body already streamed
+
+    HttpClient() = default;
+    HttpClient(const HttpClient&) = delete;
+    HttpClient& operator=(const HttpClient&) = delete;
+    ~HttpClient();
+
+    int fetch(const std::string& url, DataHandler onData, DoneHandler onDone);
+    void cancel(int id);
+    size_t pending() const;
+
+    // Waits up to timeoutMs (-1 = no limit) for network activity, or until
+    // wakeFd becomes readable, and runs the handlers for whatever happened
+    void run(int timeoutMs, int wakeFd = -1);
+
+private:
+    enum class Phase { Deferred, Connecting, Sending, Receiving };
+
+    struct Request {
+        int id;
+        std::string url;
+        URL target;
+        Phase phase = Phase::Deferred;
+        int fd = -1;
+        bool reused = false;         // fd came from the pool
+        bool receivedBytes = false;
+        bool cancelled = false;
+        int redirects = 0;
+        std::string out;
+        size_t sent = 0;
+        HttpResponse response;
+        std::unique_ptr<HttpResponseParser> parser;
+        DataHandler onData;
+        DoneHandler onDone;
+    };
+
+    struct IdleConnection {
+        int fd;
+        time_t since;
+    };
+
+    void open(Request& request, bool allowReuse = true);
+    void start(Request& request);
+    void handleEvent(Request& request, short events);
+    void receive(Request& request);
+    void retryOrFail(Request& request, const std::string& message);
+    void complete(Request& request);
+    void fail(Request& request, const std::string& message);
+    void deliver(Request& request);
+    void release(Request& request, bool reusable);
+    bool runAllDeferred();
+    void pruneIdle();
+
+    std::unordered_map<int, std::unique_ptr<Request>> requests;
+    std::unordered_map<std::string, std::vector<IdleConnection>> idle;  // keyed by "host:port"
+    int nextId = 1;
+};
+
+#endif // HTTPCLIENT_H
@@ -0,0 +1,64 @@
+#ifndef PAGECACHE_H
+#define PAGECACHE_H
+
+#include <ctime>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "HTMLParser.h"
+#include "HttpClient.h"
+#include "PageLayout.h"
+
+// Everything needed to show a page again without refetching or reparsing it
+struct PageSnapshot {
+    std::string url;                      // final URL, base for relative links
+    std::string body;
+    std::unique_ptr<HTMLParser> document;
+    std::unique_ptr<PageLayout> layout;   // attached by the renderer on first display
+    size_t scrollOffset = 0;              // text offset at the top of the screen when last shown
+    time_t freshUntil = 0;                // 0 when the server gave no freshness
+    time_t fetchedAt = 0;
+    bool loading = false;                 // body still streaming into document
+    bool prefetched = false;              // fetched in the background, not shown yet
+
+    size_t byteSize() const;
+};
+
+// LRU of page snapshots keyed by the requested URL, bounded by a byte budget.
+// Optionally backed by a directory on disk for responses that say how long
+// they stay fresh.
+class PageCache {
+public:
+    explicit PageCache(size_t byteBudget);
+
+    std::shared_ptr<PageSnapshot> find(const std::string& url);
+    std::shared_ptr<PageSnapshot> peek(const std::string& url) const;  // without counting as a use
+    void insert(const std::string& url, std::shared_ptr<PageSnapshot> snapshot);
+    size_t bytesUsed() const { return used; }
+
+    void setDiskDirectory(const std::string& directory);
+    bool loadFromDisk(const std::string& url, std::string& finalURL, std::string& body, time_t& freshUntil);
+    void storeOnDisk(const std::string& url, const PageSnapshot& snapshot);
+
+    // Expiry time from Cache-Control / Expires, or 0 if the response must not be reused
+    static time_t freshUntil(const HttpResponse& response, time_t now);
+
+private:
+    struct Entry {
+        std::string url;
+        std::shared_ptr<PageSnapshot> snapshot;
+        size_t charge;
+    };
+
+    void evict();
+    std::string diskPath(const std::string& url) const;
+
+    std::list<Entry> entries;  // most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    size_t budget;
+    size_t used = 0;
+    std::string diskDirectory;
+};
+
+#endif // PAGECACHE_H
@@ -0,0 +1,62 @@
+#ifndef PAGELAYOUT_H
+#define PAGELAYOUT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "HTMLParser.h"
+
+struct LayoutLine {
+    uint32_t offset;      // into the document text
+    uint32_t length;
+    uint32_t firstRange;  // into PageLayout::range()
+    uint32_t rangeCount;
+};
+
+// Part of a link that falls on one line, in bytes relative to the line start
+struct LinkRange {
+    uint32_t start;
+    uint32_t length;
+    uint32_t span;        // index into HTMLParser::linkSpans()
+};
+
+// The document's text wrapped to a terminal width. Paragraphs are wrapped on
+// demand, so a page (or a resize) only costs as much as has been looked at,
+// and text still streaming into the document is picked up as it arrives.
+class PageLayout {
+public:
+    PageLayout(const HTMLParser& document, int width);
+
+    int width() const { return wrapWidth; }
+    void resize(int width);
+
+    // Wraps more paragraphs until count lines exist; false if the text ran out first
+    bool ensureLines(size_t count);
+    bool complete() const;
+    size_t lineCount() const { return lines.size(); }
+    const LayoutLine& line(size_t index) const { return lines[index]; }
+    std::string_view lineText(size_t index) const;
+    const LinkRange& range(size_t index) const { return ranges[index]; }
+
+    // First line showing the given link span, or -1 if it never appears
+    long lineOfSpan(size_t span);
+    // Line containing the text offset, used to keep the view steady on resize
+    size_t lineAtOffset(size_t offset);
+
+    size_t memoryUsage() const;
+
+private:
+    bool wrapParagraph();
+    void addLine(size_t start, size_t end);
+
+    const HTMLParser& document;
+    int wrapWidth;
+    size_t wrappedUpTo = 0;  // text offset where the next paragraph starts
+    size_t nextSpan = 0;
+    std::vector<LayoutLine> lines;
+    std::vector<LinkRange> ranges;
+    std::vector<long> spanLines;  // first line of each span laid out so far
+};
+
+#endif // PAGELAYOUT_H
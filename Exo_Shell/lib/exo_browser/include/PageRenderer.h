@@ -1,18 +1,41 @@
 #ifndef PAGERENDERER_H
 #define PAGERENDERER_H
 
+#include <memory>
 #include <string>
+#include <vector>
+#include "PageLayout.h"
 #include "WebManager.h"
 
+// Draws the visible window of a page's layout. Only rows whose content
+// changed are redrawn, so scrolling and link selection cost O(screen).
 class PageRenderer {
 public:
     explicit PageRenderer(WebManager& manager);
-    void renderPage(const std::string& content);
+    ~PageRenderer();
+    void renderPage(const std::shared_ptr<PageSnapshot>& page, bool restorePosition = false);
     void highlightLink(int linkIndex);
     void scrollPage(int lines);
+    void resize();
+    void update();  // the page on screen received more content
+
+    int linkCount() const;
+    std::string linkTarget(int linkIndex) const;  // absolute URL of a selectable link
 
 private:
+    void draw();
+    void drawLine(int row, long line);
+    void markSpanDirty(int span);
+    int viewRows() const { return rows > 1 ? rows - 1 : 1; }  // last row is the status bar
+
     WebManager& webManager;
+    std::shared_ptr<PageSnapshot> page;
+    PageLayout* layout = nullptr;  // owned by the snapshot
+    size_t topLine = 0;
+    int highlighted = -1;
+    int rows = 0;
+    int cols = 0;
+    std::vector<long> shown;       // document line currently on each row, -1 blank, -2 dirty
 };
 
 #endif // PAGERENDERER_H
@@ -0,0 +1,20 @@
+#ifndef URL_H
+#define URL_H
+
+#include <string>
+
+struct URL {
+    std::string scheme;  // "http", "https" or "file"
+    std::string host;
+    int port = 0;
+    std::string path;    // includes the query string
+
+    // Accepts absolute URLs and plain filesystem paths (treated as file://)
+    static bool parse(const std::string& text, URL& out);
+    std::string str() const;
+};
+
+// Resolves a link found on the page at base into an absolute URL
+std::string resolveURL(const std::string& base, const std::string& link);
+
+#endif // URL_H
@@ -2,15 +2,19 @@
 #define USERINTERFACE_H
 
 #include "PageRenderer.h"
+#include "WebManager.h"
 
 class UserInterface {
 public:
-    explicit UserInterface(PageRenderer& renderer);
-    void processInput(char command);
+    UserInterface(PageRenderer& renderer, WebManager& manager);
+    void processInput(int command);
 
 private:
+    void show(const std::shared_ptr<PageSnapshot>& page, bool restorePosition);
+
     PageRenderer& pageRenderer;
-    int selectedLinkIndex = 0;
+    WebManager& webManager;
+    int selectedLinkIndex = -1;
 };
 
 #endif // USERINTERFACE_H
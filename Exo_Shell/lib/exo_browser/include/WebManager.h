@@ -1,22 +1,61 @@
 #ifndef WEBMANAGER_H
 #define WEBMANAGER_H
 
+#include <deque>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <stack>
+#include "HttpClient.h"
+#include "PageCache.h"
 
+// Navigation, history and the page pipeline. Pages come back immediately and
+// fill in (page->loading) while poll() drives the network, so the first
+// screen can be drawn before the body has finished arriving.
 class WebManager {
 public:
-    WebManager();
-    std::string fetchPage(const std::string& url);
-    void goBack();
-    void goForward();
-    std::string refresh();
+    explicit WebManager(size_t cacheBudget = 64 * 1024 * 1024);
+    std::shared_ptr<PageSnapshot> fetchPage(const std::string& url);
+    std::shared_ptr<PageSnapshot> goBack();     // nullptr when there is no history
+    std::shared_ptr<PageSnapshot> goForward();
+    std::shared_ptr<PageSnapshot> refresh();
+    void enableDiskCache(const std::string& directory);
+    const std::string& currentPage() const { return currentURL; }
+
+    // Runs the network for up to timeoutMs or until wakeFd is readable.
+    // Returns true when the page on screen received new content.
+    bool poll(int timeoutMs, int wakeFd = -1);
+
+    // Hint that the user may open url next; it is fetched in the background
+    void prefetch(const std::string& url);
 
 private:
+    struct Download {
+        int request;
+        std::shared_ptr<PageSnapshot> page;
+        bool prefetch;
+    };
+
+    std::shared_ptr<PageSnapshot> show(std::shared_ptr<PageSnapshot> page);
+    std::shared_ptr<PageSnapshot> load(const std::string& url, bool allowStale);
+    std::shared_ptr<PageSnapshot> download(const std::string& url, bool prefetch);
+    void finishDownload(const std::string& url, HttpResponse& response);
+    void queueLinkPrefetches(const PageSnapshot& page);
+    void startPrefetches();
+    bool isCached(const std::string& url) const;
+
     std::string currentURL;
     std::stack<std::string> backStack;
     std::stack<std::string> forwardStack;
+    PageCache cache;
+    HttpClient http;
+
+    std::shared_ptr<PageSnapshot> current;                // page being shown
+    bool currentChanged = false;
+    std::unordered_map<std::string, Download> downloads;  // in flight, keyed by requested URL
+    std::deque<std::string> prefetchQueue;
+    int prefetchesRunning = 0;
 };
 
 #endif // WEBMANAGER_H
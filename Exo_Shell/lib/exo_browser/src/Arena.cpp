@@ -0,0 +1,30 @@
+#include "../include/Arena.h"
+#include <cstring>
+
+Arena::Arena(size_t blockSize) : blockSize(blockSize) {}
+
+char* Arena::allocate(size_t size) {
+    if (size > remaining) {
+        // Oversized requests get a block of their own so the current block
+        // keeps its tail for the next small string
+        size_t newSize = size > blockSize / 4 ? size : blockSize;
+        blocks.emplace_back(new char[newSize]);
+        reserved += newSize;
+        if (newSize != blockSize) {
+            return blocks.back().get();
+        }
+        cursor = blocks.back().get();
+        remaining = newSize;
+    }
+    char* result = cursor;
+    cursor += size;
+    remaining -= size;
+    return result;
+}
+
+std::string_view Arena::store(std::string_view bytes) {
+    if (bytes.empty()) return {};
+    char* copy = allocate(bytes.size());
+    std::memcpy(copy, bytes.data(), bytes.size());
+    return std::string_view(copy, bytes.size());
+}
@@ -1,7 +1,126 @@
 #include "../include/HTMLParser.h"
+#include <algorithm>
 
-HTMLParser::HTMLParser(const std::string& html) : htmlContent(html) {}
+namespace {
+
+// Elements that start on a line of their own in the text view
+bool isBlockElement(std::string_view name) {
+    static const std::string_view blocks[] = {
+        "p", "div", "h1", "h2", "h3", "h4", "h5", "h6", "li", "ul", "ol", "dl", "dt", "dd",
+        "tr", "table", "title", "section", "article", "header", "footer", "nav", "main",
+        "aside", "blockquote", "pre", "hr", "form", "figure",
+    };
+    return std::find(std::begin(blocks), std::end(blocks), name) != std::end(blocks);
+}
+
+} // namespace
+
+HTMLParser::HTMLParser()
+    : tokenizer([this](const HTMLToken& token) { handleToken(token); }) {}
+
+HTMLParser::HTMLParser(const std::string& html) : HTMLParser() {
+    feed(html);
+    finish();
+}
+
+void HTMLParser::feed(std::string_view chunk) {
+    tokenizer.feed(chunk);
+}
+
+void HTMLParser::finish() {
+    tokenizer.finish();
+    closeAnchor();
+    breakLine();
+    finished = true;
+}
 
 std::vector<std::string> HTMLParser::getLinks() {
-    return {"http://example.com", "http://example.org"};
+    return std::vector<std::string>(linkTargets.begin(), linkTargets.end());
+}
+
+size_t HTMLParser::memoryUsage() const {
+    return arena.bytesUsed() + text.capacity() + linkTargets.capacity() * sizeof(std::string_view) +
+           spans.capacity() * sizeof(LinkSpan);
+}
+
+void HTMLParser::handleToken(const HTMLToken& token) {
+    switch (token.type) {
+    case TokenType::StartTag:
+        anchorOpen = token.name == "a";
+        if (anchorOpen) closeAnchor(); // <a> elements don't nest
+        if (token.name == "br") {
+            text.push_back('\n');
+            pendingSpace = false;
+        } else if (isBlockElement(token.name)) {
+            breakLine();
+            if (token.name == "pre" && !token.selfClosing) ++preDepth;
+        }
+        break;
+    case TokenType::EndTag:
+        anchorOpen = false;
+        if (token.name == "a") closeAnchor();
+        if (isBlockElement(token.name)) {
+            breakLine();
+            if (token.name == "pre" && preDepth > 0) --preDepth;
+        }
+        break;
+    case TokenType::Attribute:
+        if (anchorOpen && token.name == "href" && !token.value.empty()) {
+            HTMLTokenizer::decodeEntities(token.value, scratch);
+            linkTargets.push_back(arena.store(scratch));
+            spans.push_back(LinkSpan{text.size(), std::string::npos, linkTargets.size() - 1});
+            spanOpen = true;
+        }
+        break;
+    case TokenType::Text:
+        appendText(token.value);
+        break;
+    default:
+        break; // comments, doctype and script/style bodies are not displayed
+    }
+}
+
+void HTMLParser::appendText(std::string_view chunk) {
+    if (preDepth > 0) {
+        // Keep preformatted text as is, but expand tabs so columns line up
+        for (char c : chunk) {
+            if (c == '\t') {
+                size_t column = text.size() - (text.rfind('\n') + 1);
+                text.append(8 - column % 8, ' ');
+            } else if (c != '\r') {
+                text.push_back(c);
+            }
+        }
+        return;
+    }
+    // Collapse runs of whitespace into one space, dropped at line starts
+    for (char c : chunk) {
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f') {
+            pendingSpace = true;
+            continue;
+        }
+        if (pendingSpace && !text.empty() && text.back() != '\n') {
+            text.push_back(' ');
+        }
+        pendingSpace = false;
+        text.push_back(c);
+    }
+}
+
+// Finishes the current link span, trimmed to the text that was displayed
+void HTMLParser::closeAnchor() {
+    if (!spanOpen) return;
+    spanOpen = false;
+    LinkSpan& span = spans.back();
+    span.end = text.size();
+    while (span.start < span.end && (text[span.start] == ' ' || text[span.start] == '\n')) ++span.start;
+    while (span.end > span.start && (text[span.end - 1] == ' ' || text[span.end - 1] == '\n')) --span.end;
+    if (span.start == span.end) spans.pop_back(); // nothing visible to select
+}
+
+void HTMLParser::breakLine() {
+    pendingSpace = false;
+    if (!text.empty() && text.back() != '\n') {
+        text.push_back('\n');
+    }
 }
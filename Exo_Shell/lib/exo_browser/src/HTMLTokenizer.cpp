@@ -0,0 +1,396 @@
+#include "../include/HTMLTokenizer.h"
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+const size_t kMaxEntityLength = 32;
+
+// Returns the first byte in [p, end) equal to a, b or c (end if none).
+// 16 bytes are compared per step where SSE2 or NEON is available.
+const char* scanFor(const char* p, const char* end, char a, char b, char c) {
+#if defined(__SSE2__)
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    const __m128i vc = _mm_set1_epi8(c);
+    while (end - p >= 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, va), _mm_cmpeq_epi8(block, vb)),
+                                    _mm_cmpeq_epi8(block, vc));
+        int mask = _mm_movemask_epi8(hits);
+        if (mask != 0) return p + __builtin_ctz(mask);
+        p += 16;
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t va = vdupq_n_u8(static_cast<uint8_t>(a));
+    const uint8x16_t vb = vdupq_n_u8(static_cast<uint8_t>(b));
+    const uint8x16_t vc = vdupq_n_u8(static_cast<uint8_t>(c));
+    while (end - p >= 16) {
+        uint8x16_t block = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+        uint8x16_t hits = vorrq_u8(vorrq_u8(vceqq_u8(block, va), vceqq_u8(block, vb)), vceqq_u8(block, vc));
+        // Narrow each byte to a nibble so the match position fits in 64 bits
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hits), 4)), 0);
+        if (mask != 0) return p + (__builtin_ctzll(mask) >> 2);
+        p += 16;
+    }
+#endif
+    for (; p < end; ++p) {
+        if (*p == a || *p == b || *p == c) return p;
+    }
+    return end;
+}
+
+inline bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+inline bool isAlpha(char c) {
+    return std::isalpha(static_cast<unsigned char>(c)) != 0;
+}
+
+inline bool isEntityChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) != 0 || c == '#';
+}
+
+bool startsWithNoCase(const char* p, const char* end, std::string_view prefix) {
+    if (static_cast<size_t>(end - p) < prefix.size()) return false;
+    for (size_t i = 0; i < prefix.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(p[i])) != prefix[i]) return false;
+    }
+    return true;
+}
+
+size_t encodeUTF8(uint32_t codepoint, char* out) {
+    if (codepoint == 0 || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF)) {
+        codepoint = 0xFFFD;
+    }
+    if (codepoint < 0x80) {
+        out[0] = static_cast<char>(codepoint);
+        return 1;
+    }
+    if (codepoint < 0x800) {
+        out[0] = static_cast<char>(0xC0 | (codepoint >> 6));
+        out[1] = static_cast<char>(0x80 | (codepoint & 0x3F));
+        return 2;
+    }
+    if (codepoint < 0x10000) {
+        out[0] = static_cast<char>(0xE0 | (codepoint >> 12));
+        out[1] = static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        out[2] = static_cast<char>(0x80 | (codepoint & 0x3F));
+        return 3;
+    }
+    out[0] = static_cast<char>(0xF0 | (codepoint >> 18));
+    out[1] = static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+    out[2] = static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+    out[3] = static_cast<char>(0x80 | (codepoint & 0x3F));
+    return 4;
+}
+
+// Decodes the reference between '&' and ';' into out (at least 4 bytes).
+// Returns 0 for references we don't know, which are then left as written.
+size_t decodeReference(std::string_view name, char* out) {
+    if (name.size() > 1 && name[0] == '#') {
+        bool hex = name[1] == 'x' || name[1] == 'X';
+        uint32_t codepoint = 0;
+        for (size_t i = hex ? 2 : 1; i < name.size(); ++i) {
+            char c = name[i];
+            uint32_t digit;
+            if (c >= '0' && c <= '9') digit = c - '0';
+            else if (hex && c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+            else if (hex && c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+            else return 0;
+            codepoint = std::min<uint32_t>(codepoint * (hex ? 16 : 10) + digit, 0x110000);
+        }
+        return encodeUTF8(codepoint, out);
+    }
+
+    static const struct { std::string_view name; uint32_t codepoint; } named[] = {
+        {"amp", '&'}, {"lt", '<'}, {"gt", '>'}, {"quot", '"'}, {"apos", '\''},
+        {"nbsp", ' '}, {"copy", 0xA9}, {"reg", 0xAE}, {"trade", 0x2122},
+        {"mdash", 0x2014}, {"ndash", 0x2013}, {"hellip", 0x2026}, {"middot", 0xB7},
+        {"laquo", 0xAB}, {"raquo", 0xBB}, {"lsquo", 0x2018}, {"rsquo", 0x2019},
+        {"ldquo", 0x201C}, {"rdquo", 0x201D}, {"bull", 0x2022},
+    };
+    for (const auto& entity : named) {
+        if (entity.name == name) return encodeUTF8(entity.codepoint, out);
+    }
+    return 0;
+}
+
+} // namespace
+
+HTMLTokenizer::HTMLTokenizer(TokenHandler handler) : handler(std::move(handler)) {}
+
+void HTMLTokenizer::feed(std::string_view chunk) {
+    if (pending.empty()) {
+        // Common case: tokenize straight out of the caller's buffer
+        size_t used = tokenize(chunk, false);
+        pending.assign(chunk.substr(used));
+    } else {
+        pending.append(chunk);
+        size_t used = tokenize(pending, false);
+        pending.erase(0, used);
+    }
+}
+
+void HTMLTokenizer::finish() {
+    std::string tail;
+    tail.swap(pending);
+    tokenize(tail, true);
+    rawTextTag.clear();
+    scanned = 0;
+    openQuote = 0;
+}
+
+size_t HTMLTokenizer::tokenize(std::string_view buffer, bool atEnd) {
+    const char* p = buffer.data();
+    const char* end = p + buffer.size();
+
+    while (p < end) {
+        const char* next;
+        if (!rawTextTag.empty()) {
+            next = parseRawText(p, end, atEnd);
+            if (next == p && rawTextTag.empty()) continue; // empty element, its end tag is next
+        } else if (*p == '<') {
+            next = parseMarkup(p, end, atEnd);
+        } else if (*p == '&') {
+            next = parseEntity(p, end, atEnd);
+        } else {
+            next = scanFor(p, end, '<', '&', '&');
+            emit(TokenType::Text, {}, std::string_view(p, next - p));
+        }
+        if (next == p) break; // incomplete, wait for the next chunk
+        p = next;
+        scanned = 0; // resume state only ever describes the construct we stop at
+        openQuote = 0;
+    }
+    return p - buffer.data();
+}
+
+// p points at '<'. Returns p unchanged when more input is needed, after
+// noting in scanned how much of the construct needs no second look.
+const char* HTMLTokenizer::parseMarkup(const char* p, const char* end, bool atEnd) {
+    if (end - p < 3 && !atEnd) return p;
+    if (end - p < 2) {
+        emit(TokenType::Text, {}, "<");
+        return p + 1;
+    }
+
+    char next = p[1];
+    char third = end - p > 2 ? p[2] : '\0';
+    if (next == '!' && startsWithNoCase(p, end, "<!--")) {
+        // "--" is checked behind each '>', so resuming at the old end is safe
+        for (const char* q = std::max(p + 4, p + scanned); (q = scanFor(q, end, '>', '>', '>')) != end; ++q) {
+            if (q - p >= 6 && q[-1] == '-' && q[-2] == '-') {
+                emit(TokenType::Comment, {}, std::string_view(p + 4, q - 2 - (p + 4)));
+                return q + 1;
+            }
+        }
+        if (!atEnd) {
+            scanned = end - p;
+            return p;
+        }
+        emit(TokenType::Comment, {}, std::string_view(p + 4, end - (p + 4)));
+        return end;
+    }
+    if (next == '!' && end - p < 4 && !atEnd) return p; // can't tell "<!-" from a comment yet
+
+    if (next == '!' || next == '?' || (next == '/' && !isAlpha(third))) {
+        // Doctype, processing instruction or bogus comment: skip to '>'
+        const char* gt = scanFor(std::max(p + 2, p + scanned), end, '>', '>', '>');
+        if (gt == end && !atEnd) {
+            scanned = end - p;
+            return p;
+        }
+        std::string_view body(p + 2, gt - (p + 2));
+        bool doctype = next == '!' && startsWithNoCase(body.data(), gt, "doctype");
+        emit(doctype ? TokenType::Doctype : TokenType::Comment, {}, body);
+        return gt == end ? end : gt + 1;
+    }
+
+    if (isAlpha(next) || next == '/') {
+        return parseTag(p, end, atEnd);
+    }
+
+    emit(TokenType::Text, {}, "<");
+    return p + 1;
+}
+
+const char* HTMLTokenizer::parseTag(const char* p, const char* end, bool atEnd) {
+    bool isEndTag = p[1] == '/';
+    const char* nameStart = p + (isEndTag ? 2 : 1);
+
+    // Find the closing '>', stepping over quoted attribute values. Carries on
+    // from where the previous chunk left off, possibly inside a value.
+    const char* gt = std::max(nameStart, p + scanned);
+    char quote = openQuote;
+    while (gt < end) {
+        if (quote != 0) {
+            const char* close = scanFor(gt, end, quote, quote, quote);
+            if (close == end) {
+                gt = end;
+                break;
+            }
+            quote = 0;
+            gt = close + 1;
+            continue;
+        }
+        gt = scanFor(gt, end, '>', '"', '\'');
+        if (gt == end || *gt == '>') break;
+        const char* before = gt - 1;
+        while (before > nameStart && isSpace(*before)) --before;
+        if (*before == '=') quote = *gt; // else a stray quote outside a value
+        ++gt;
+    }
+    if (gt == end) {
+        if (!atEnd) {
+            scanned = end - p;
+            openQuote = quote;
+            return p;
+        }
+        emit(TokenType::Text, {}, std::string_view(p, end - p));
+        return end;
+    }
+
+    const char* nameEnd = nameStart;
+    while (nameEnd < gt && !isSpace(*nameEnd) && *nameEnd != '/') ++nameEnd;
+    std::string_view name = lowered(std::string_view(nameStart, nameEnd - nameStart), tagName);
+
+    if (isEndTag) {
+        emit(TokenType::EndTag, name, {});
+        return gt + 1;
+    }
+
+    bool selfClosing = gt[-1] == '/' && gt - 1 >= nameEnd;
+    emit(TokenType::StartTag, name, {}, selfClosing);
+
+    const char* a = nameEnd;
+    while (a < gt) {
+        while (a < gt && (isSpace(*a) || *a == '/')) ++a;
+        const char* attrStart = a;
+        while (a < gt && !isSpace(*a) && *a != '=' && *a != '/') ++a;
+        if (a == attrStart) {
+            if (a < gt) ++a; // stray '='
+            continue;
+        }
+        std::string_view attr(attrStart, a - attrStart);
+
+        while (a < gt && isSpace(*a)) ++a;
+        std::string_view value;
+        if (a < gt && *a == '=') {
+            ++a;
+            while (a < gt && isSpace(*a)) ++a;
+            if (a < gt && (*a == '"' || *a == '\'')) {
+                const char* valueEnd = std::find(a + 1, gt, *a);
+                value = std::string_view(a + 1, valueEnd - (a + 1));
+                a = valueEnd < gt ? valueEnd + 1 : gt;
+            } else {
+                const char* valueStart = a;
+                while (a < gt && !isSpace(*a)) ++a;
+                value = std::string_view(valueStart, a - valueStart);
+            }
+        }
+        emit(TokenType::Attribute, lowered(attr, attrName), value);
+    }
+
+    if (!selfClosing && (name == "script" || name == "style")) {
+        rawTextTag.assign(name);
+    }
+    return gt + 1;
+}
+
+// p points at '&'. Decoded text goes out as its own Text token.
+const char* HTMLTokenizer::parseEntity(const char* p, const char* end, bool atEnd) {
+    const char* limit = std::min(end, p + kMaxEntityLength);
+    const char* q = p + 1;
+    while (q < limit && isEntityChar(*q)) ++q;
+
+    if (q == end && !atEnd && end - p < static_cast<ptrdiff_t>(kMaxEntityLength)) return p;
+    if (q == limit || *q != ';' || q == p + 1) {
+        emit(TokenType::Text, {}, "&");
+        return p + 1;
+    }
+
+    size_t length = decodeReference(std::string_view(p + 1, q - (p + 1)), entityBuffer);
+    if (length == 0) {
+        emit(TokenType::Text, {}, std::string_view(p, q + 1 - p));
+    } else {
+        emit(TokenType::Text, {}, std::string_view(entityBuffer, length));
+    }
+    return q + 1;
+}
+
+// Inside <script>/<style> everything up to the matching end tag is raw text
+const char* HTMLTokenizer::parseRawText(const char* p, const char* end, bool atEnd) {
+    const size_t closeLength = rawTextTag.size() + 3; // "</" + name + '>'
+    const char* q = p;
+    while ((q = scanFor(q, end, '<', '<', '<')) != end) {
+        if (static_cast<size_t>(end - q) < closeLength && !atEnd) break;
+        if (q + 1 < end && q[1] == '/' && startsWithNoCase(q + 2, end, rawTextTag)) {
+            char after = q + 2 + rawTextTag.size() < end ? q[2 + rawTextTag.size()] : '>';
+            if (after == '>' || after == '/' || isSpace(after)) {
+                if (q > p) emit(TokenType::RawText, {}, std::string_view(p, q - p));
+                rawTextTag.clear();
+                return q;
+            }
+        }
+        ++q;
+    }
+    if (q == end) {
+        if (q > p) emit(TokenType::RawText, {}, std::string_view(p, q - p));
+        return end;
+    }
+    // A possible end tag straddles the chunk boundary
+    if (q > p) emit(TokenType::RawText, {}, std::string_view(p, q - p));
+    return q;
+}
+
+void HTMLTokenizer::emit(TokenType type, std::string_view name, std::string_view value, bool selfClosing) {
+    HTMLToken token{type, name, value, selfClosing};
+    handler(token);
+}
+
+std::string_view HTMLTokenizer::lowered(std::string_view name, std::string& buffer) {
+    bool hasUpper = std::any_of(name.begin(), name.end(),
+                                [](char c) { return c >= 'A' && c <= 'Z'; });
+    if (!hasUpper) return name;
+    buffer.assign(name);
+    for (char& c : buffer) {
+        if (c >= 'A' && c <= 'Z') c = c - 'A' + 'a';
+    }
+    return buffer;
+}
+
+void HTMLTokenizer::decodeEntities(std::string_view raw, std::string& out) {
+    out.clear();
+    const char* p = raw.data();
+    const char* end = p + raw.size();
+    char decoded[4];
+    while (p < end) {
+        const char* amp = scanFor(p, end, '&', '&', '&');
+        out.append(p, amp - p);
+        if (amp == end) break;
+
+        const char* q = amp + 1;
+        while (q < end && isEntityChar(*q)) ++q;
+        size_t length = 0;
+        if (q < end && *q == ';' && q > amp + 1) {
+            length = decodeReference(std::string_view(amp + 1, q - (amp + 1)), decoded);
+        }
+        if (length == 0) {
+            out.push_back('&');
+            p = amp + 1;
+        } else {
+            out.append(decoded, length);
+            p = q + 1;
+        }
+    }
+}
@@ -0,0 +1,495 @@
+#include "../include/HttpClient.h"
+#include "../include/URL.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0  // macOS: SO_NOSIGPIPE is set on the socket instead
+#endif
+
+namespace {
+
+const int kMaxRedirects = 5;
+const size_t kMaxIdlePerHost = 4;
+const int kIdleSeconds = 30;
+
+std::string hostKey(const URL& url) {
+    return url.host + ":" + std::to_string(url.port);
+}
+
+bool isRedirect(const HttpResponse& response) {
+    return response.status >= 300 && response.status < 400 && response.status != 304 &&
+           !response.header("location").empty();
+}
+
+std::string trim(std::string_view text) {
+    size_t start = text.find_first_not_of(" \t");
+    if (start == std::string_view::npos) return "";
+    size_t end = text.find_last_not_of(" \t");
+    return std::string(text.substr(start, end - start + 1));
+}
+
+} // namespace
+
+std::string HttpResponse::header(std::string_view name) const {
+    for (const auto& entry : headers) {
+        if (entry.first == name) return entry.second;
+    }
+    return "";
+}
+
+HttpResponseParser::HttpResponseParser(HttpResponse& response) : response(response) {}
+
+bool HttpResponseParser::feed(std::string_view data) {
+    while (!data.empty() && state != State::Done) {
+        switch (state) {
+        case State::StatusLine:
+            if (!takeLine(data)) return true;
+            if (line.compare(0, 5, "HTTP/") != 0 || line.find(' ') == std::string::npos) return false;
+            response.status = std::atoi(line.c_str() + line.find(' ') + 1);
+            http11 = line.compare(0, 8, "HTTP/1.1") == 0;
+            line.clear();
+            state = State::Headers;
+            break;
+        case State::Headers:
+            if (!takeLine(data)) return true;
+            if (line.empty()) {
+                if (!headersDone()) return false;
+            } else {
+                size_t colon = line.find(':');
+                if (colon == std::string::npos) return false;
+                std::string name = line.substr(0, colon);
+                std::transform(name.begin(), name.end(), name.begin(),
+                               [](unsigned char c) { return std::tolower(c); });
+                response.headers.emplace_back(name, trim(std::string_view(line).substr(colon + 1)));
+            }
+            line.clear();
+            break;
+        case State::Body:
+        case State::ChunkData: {
+            size_t take = std::min(remaining, data.size());
+            response.body.append(data.data(), take);
+            data.remove_prefix(take);
+            remaining -= take;
+            if (remaining == 0) state = state == State::Body ? State::Done : State::ChunkEnd;
+            break;
+        }
+        case State::ChunkSize: {
+            if (!takeLine(data)) return true;
+            char* end = nullptr;
+            remaining = std::strtoul(line.c_str(), &end, 16);
+            if (end == line.c_str()) return false;
+            line.clear();
+            state = remaining == 0 ? State::Trailers : State::ChunkData;
+            break;
+        }
+        case State::ChunkEnd:
+            if (!takeLine(data)) return true;
+            line.clear();
+            state = State::ChunkSize;
+            break;
+        case State::Trailers:
+            if (!takeLine(data)) return true;
+            if (line.empty()) state = State::Done;
+            line.clear();
+            break;
+        case State::UntilClose:
+            response.body.append(data.data(), data.size());
+            data = {};
+            break;
+        case State::Done:
+            break;
+        }
+    }
+    return true;
+}
+
+void HttpResponseParser::finishOnClose() {
+    if (state == State::UntilClose) state = State::Done;
+}
+
+bool HttpResponseParser::keepAlive() const {
+    if (state != State::Done || closeDelimited) return false;
+    std::string connection = response.header("connection");
+    std::transform(connection.begin(), connection.end(), connection.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    if (connection.find("close") != std::string::npos) return false;
+    return http11 || connection.find("keep-alive") != std::string::npos;
+}
+
+// Accumulates into line until '\n'; returns true once a full line is there
+bool HttpResponseParser::takeLine(std::string_view& data) {
+    size_t newline = data.find('\n');
+    if (newline == std::string_view::npos) {
+        line.append(data.data(), data.size());
+        data = {};
+        return false;
+    }
+    line.append(data.data(), newline);
+    data.remove_prefix(newline + 1);
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    return true;
+}
+
+bool HttpResponseParser::headersDone() {
+    if (response.status >= 100 && response.status < 200) {
+        // Interim response, the real one follows
+        response.headers.clear();
+        state = State::StatusLine;
+        return true;
+    }
+    if (response.status == 204 || response.status == 304) {
+        state = State::Done;
+        return true;
+    }
+    if (response.header("transfer-encoding").find("chunked") != std::string::npos) {
+        state = State::ChunkSize;
+        return true;
+    }
+    std::string length = response.header("content-length");
+    if (!length.empty()) {
+        char* end = nullptr;
+        remaining = std::strtoull(length.c_str(), &end, 10);
+        if (end == length.c_str()) return false;
+        state = remaining == 0 ? State::Done : State::Body;
+        return true;
+    }
+    state = State::UntilClose;
+    closeDelimited = true;
+    return true;
+}
+
+HttpClient::~HttpClient() {
+    for (auto& entry : requests) {
+        if (entry.second->fd >= 0) close(entry.second->fd);
+    }
+    for (auto& host : idle) {
+        for (const IdleConnection& connection : host.second) close(connection.fd);
+    }
+}
+
+int HttpClient::fetch(const std::string& url, DataHandler onData, DoneHandler onDone) {
+    // Nothing is dispatched from in here: lookups, connects and file reads all
+    // happen in run(), so handlers never fire before fetch() has returned
+    auto request = std::make_unique<Request>();
+    request->id = nextId++;
+    request->url = url;
+    request->onData = std::move(onData);
+    request->onDone = std::move(onDone);
+    int id = request->id;
+    requests[id] = std::move(request);
+    return id;
+}
+
+void HttpClient::cancel(int id) {
+    auto found = requests.find(id);
+    if (found == requests.end()) return;
+    // Erased at the end of run(); a handler further up the stack may still hold it
+    found->second->cancelled = true;
+    release(*found->second, false);
+}
+
+size_t HttpClient::pending() const {
+    return std::count_if(requests.begin(), requests.end(),
+                         [](const auto& entry) { return !entry.second->cancelled; });
+}
+
+void HttpClient::run(int timeoutMs, int wakeFd) {
+    pruneIdle();
+    if (runAllDeferred()) timeoutMs = 0;
+
+    // Idle connections are checked for expiry at least once a second
+    bool haveIdle = std::any_of(idle.begin(), idle.end(), [](const auto& host) { return !host.second.empty(); });
+    if (haveIdle && (timeoutMs < 0 || timeoutMs > 1000)) timeoutMs = 1000;
+
+    std::vector<pollfd> fds;
+    std::vector<int> owners;  // request id, 0 for wakeFd, -1 for a pooled connection
+    for (const auto& entry : requests) {
+        const Request& request = *entry.second;
+        if (request.cancelled || request.fd < 0) continue;
+        fds.push_back(pollfd{request.fd, static_cast<short>(request.phase == Phase::Receiving ? POLLIN : POLLOUT), 0});
+        owners.push_back(request.id);
+    }
+    for (const auto& host : idle) {
+        for (const IdleConnection& connection : host.second) {
+            fds.push_back(pollfd{connection.fd, POLLIN, 0});
+            owners.push_back(-1);
+        }
+    }
+    if (wakeFd >= 0) {
+        fds.push_back(pollfd{wakeFd, POLLIN, 0});
+        owners.push_back(0);
+    }
+    if (fds.empty()) return;
+
+    if (poll(fds.data(), fds.size(), timeoutMs) > 0) {
+        for (size_t i = 0; i < fds.size(); ++i) {
+            if (fds[i].revents == 0 || owners[i] == 0) continue;
+            if (owners[i] < 0) {
+                // A pooled connection became readable: the server closed it
+                for (auto& host : idle) {
+                    auto& pool = host.second;
+                    auto match = std::find_if(pool.begin(), pool.end(),
+                                              [&](const IdleConnection& c) { return c.fd == fds[i].fd; });
+                    if (match != pool.end()) {
+                        close(match->fd);
+                        pool.erase(match);
+                        break;
+                    }
+                }
+                continue;
+            }
+            auto found = requests.find(owners[i]);
+            if (found == requests.end() || found->second->cancelled || found->second->fd != fds[i].fd) continue;
+            handleEvent(*found->second, fds[i].revents);
+        }
+    }
+
+    runAllDeferred(); // redirects and requests started by handlers
+    for (auto it = requests.begin(); it != requests.end();) {
+        it = it->second->cancelled ? requests.erase(it) : std::next(it);
+    }
+}
+
+bool HttpClient::runAllDeferred() {
+    bool ran = false;
+    std::vector<int> ids;
+    for (const auto& entry : requests) {
+        if (!entry.second->cancelled && entry.second->phase == Phase::Deferred) ids.push_back(entry.first);
+    }
+    for (int id : ids) {
+        auto found = requests.find(id);
+        if (found == requests.end() || found->second->cancelled) continue;
+        start(*found->second);
+        ran = true;
+    }
+    return ran;
+}
+
+void HttpClient::start(Request& request) {
+    request.response.url = request.url;
+    if (!URL::parse(request.url, request.target)) {
+        fail(request, "Invalid URL: " + request.url);
+        return;
+    }
+
+    if (request.target.scheme == "file") {
+        std::ifstream file(request.target.path, std::ios::binary);
+        if (!file) {
+            fail(request, "Could not open file: " + request.target.path);
+            return;
+        }
+        std::ostringstream contents;
+        contents << file.rdbuf();
+        request.response.status = 200;
+        request.onData(contents.str());
+        if (!request.cancelled) complete(request);
+        return;
+    }
+    if (request.target.scheme != "http") {
+        fail(request, request.target.scheme + ":// is not supported");
+        return;
+    }
+    open(request);
+}
+
+void HttpClient::open(Request& request, bool allowReuse) {
+    const URL& target = request.target;
+    request.parser = std::make_unique<HttpResponseParser>(request.response);
+    request.receivedBytes = false;
+    request.sent = 0;
+    request.out = "GET " + target.path + " HTTP/1.1\r\n"
+                  "Host: " + target.host + (target.port != 80 ? ":" + std::to_string(target.port) : "") + "\r\n"
+                  "User-Agent: exo_browser\r\n"
+                  "Accept-Encoding: identity\r\n"
+                  "Connection: keep-alive\r\n\r\n";
+
+    auto pool = idle.find(hostKey(target));
+    if (allowReuse && pool != idle.end() && !pool->second.empty()) {
+        request.fd = pool->second.back().fd;
+        pool->second.pop_back();
+        request.reused = true;
+        request.phase = Phase::Sending;
+        return;
+    }
+    request.reused = false;
+
+    // Name lookup still blocks; connecting, sending and receiving do not
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    int lookup = getaddrinfo(target.host.c_str(), std::to_string(target.port).c_str(), &hints, &addresses);
+    if (lookup != 0) {
+        fail(request, "Could not resolve " + target.host + ": " + gai_strerror(lookup));
+        return;
+    }
+
+    for (addrinfo* address = addresses; address != nullptr; address = address->ai_next) {
+        int fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (fd < 0) continue;
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+#ifdef SO_NOSIGPIPE
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+        bool connected = connect(fd, address->ai_addr, address->ai_addrlen) == 0;
+        if (connected || errno == EINPROGRESS) {
+            request.fd = fd;
+            request.phase = connected ? Phase::Sending : Phase::Connecting;
+            break;
+        }
+        close(fd);
+    }
+    freeaddrinfo(addresses);
+    if (request.fd < 0) fail(request, "Could not connect to " + target.host);
+}
+
+void HttpClient::handleEvent(Request& request, short events) {
+    if (request.phase == Phase::Connecting) {
+        int error = 0;
+        socklen_t length = sizeof(error);
+        getsockopt(request.fd, SOL_SOCKET, SO_ERROR, &error, &length);
+        if (error != 0) {
+            fail(request, "Could not connect to " + request.target.host + ": " + std::strerror(error));
+            return;
+        }
+        request.phase = Phase::Sending;
+    }
+
+    if (request.phase == Phase::Sending) {
+        while (request.sent < request.out.size()) {
+            ssize_t n = send(request.fd, request.out.data() + request.sent, request.out.size() - request.sent, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+                retryOrFail(request, "Failed to send request to " + request.target.host);
+                return;
+            }
+            request.sent += n;
+        }
+        request.phase = Phase::Receiving;
+        return;
+    }
+
+    if (events & (POLLIN | POLLHUP | POLLERR)) receive(request);
+}
+
+void HttpClient::receive(Request& request) {
+    char buffer[65536];
+    ssize_t n = recv(request.fd, buffer, sizeof(buffer), 0);
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+        retryOrFail(request, "Connection to " + request.target.host + " failed");
+        return;
+    }
+    if (n == 0) {
+        if (request.reused && !request.receivedBytes) {
+            retryOrFail(request, "");
+            return;
+        }
+        request.parser->finishOnClose();
+        if (request.parser->complete()) {
+            complete(request);
+        } else {
+            fail(request, "Connection closed before the response was complete");
+        }
+        return;
+    }
+
+    request.receivedBytes = true;
+    if (!request.parser->feed(std::string_view(buffer, n))) {
+        fail(request, "Malformed response from " + request.target.host);
+        return;
+    }
+
+    // Hand over whatever body arrived; redirect bodies are dropped
+    if (!request.response.body.empty() && !isRedirect(request.response)) {
+        std::string chunk;
+        chunk.swap(request.response.body);
+        request.onData(chunk);
+        if (request.cancelled) return;
+        chunk.clear();
+        request.response.body.swap(chunk); // keep the capacity for the next read
+    }
+    if (request.parser->complete()) complete(request);
+}
+
+// A pooled connection may have been closed by the server while idle; that
+// only shows up on first use, so retry once on a fresh connection
+void HttpClient::retryOrFail(Request& request, const std::string& message) {
+    if (!request.reused || request.receivedBytes) {
+        fail(request, message);
+        return;
+    }
+    release(request, false);
+    request.response = HttpResponse();
+    request.response.url = request.url;
+    open(request, false);
+}
+
+void HttpClient::complete(Request& request) {
+    bool reusable = request.parser && request.parser->keepAlive();
+    release(request, reusable);
+
+    if (isRedirect(request.response)) {
+        if (request.redirects < kMaxRedirects) {
+            request.url = resolveURL(request.url, request.response.header("location"));
+            request.response = HttpResponse();
+            request.redirects++;
+            request.phase = Phase::Deferred;
+            return;
+        }
+        request.response.error = "Too many redirects";
+    }
+    deliver(request);
+}
+
+void HttpClient::fail(Request& request, const std::string& message) {
+    release(request, false);
+    request.response.error = message;
+    deliver(request);
+}
+
+// Removes the request and reports the outcome to its owner
+void HttpClient::deliver(Request& request) {
+    auto found = requests.find(request.id);
+    std::unique_ptr<Request> finished = std::move(found->second);
+    requests.erase(found);
+    finished->response.url = finished->url;
+    finished->onDone(finished->response);
+}
+
+void HttpClient::release(Request& request, bool reusable) {
+    if (request.fd < 0) return;
+    std::vector<IdleConnection>& pool = idle[hostKey(request.target)];
+    if (reusable && pool.size() < kMaxIdlePerHost) {
+        pool.push_back(IdleConnection{request.fd, time(nullptr)});
+    } else {
+        close(request.fd);
+    }
+    request.fd = -1;
+}
+
+void HttpClient::pruneIdle() {
+    time_t now = time(nullptr);
+    for (auto& host : idle) {
+        auto& pool = host.second;
+        pool.erase(std::remove_if(pool.begin(), pool.end(),
+                                  [&](const IdleConnection& connection) {
+                                      if (now - connection.since < kIdleSeconds) return false;
+                                      close(connection.fd);
+                                      return true;
+                                  }),
+                   pool.end());
+    }
+}
@@ -0,0 +1,148 @@
+#include "../include/PageCache.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+const char kDiskMagic[] = "exo-cache 1";
+
+bool parseHttpDate(const std::string& text, time_t& out) {
+    tm parsed = {};
+    if (text.empty() || strptime(text.c_str(), "%a, %d %b %Y %H:%M:%S", &parsed) == nullptr) return false;
+    out = timegm(&parsed);
+    return true;
+}
+
+} // namespace
+
+size_t PageSnapshot::byteSize() const {
+    return sizeof(PageSnapshot) + url.capacity() + body.capacity() + (document ? document->memoryUsage() : 0) +
+           (layout ? layout->memoryUsage() : 0);
+}
+
+PageCache::PageCache(size_t byteBudget) : budget(byteBudget) {}
+
+std::shared_ptr<PageSnapshot> PageCache::find(const std::string& url) {
+    auto found = index.find(url);
+    if (found == index.end()) return nullptr;
+    entries.splice(entries.begin(), entries, found->second);
+
+    // The layout grows while a page is on screen, so recharge on every use
+    Entry& entry = *found->second;
+    std::shared_ptr<PageSnapshot> snapshot = entry.snapshot;
+    size_t charge = snapshot->byteSize();
+    used = used - entry.charge + charge;
+    entry.charge = charge;
+    evict();
+    return snapshot;
+}
+
+std::shared_ptr<PageSnapshot> PageCache::peek(const std::string& url) const {
+    auto found = index.find(url);
+    return found == index.end() ? nullptr : found->second->snapshot;
+}
+
+void PageCache::insert(const std::string& url, std::shared_ptr<PageSnapshot> snapshot) {
+    auto found = index.find(url);
+    if (found != index.end()) {
+        used -= found->second->charge;
+        entries.erase(found->second);
+        index.erase(found);
+    }
+    size_t charge = snapshot->byteSize();
+    entries.push_front(Entry{url, std::move(snapshot), charge});
+    index[url] = entries.begin();
+    used += charge;
+    evict();
+}
+
+void PageCache::evict() {
+    // Pages still on screen or in a caller's hands stay alive through their
+    // shared_ptr; the cache just stops counting them
+    while (used > budget && !entries.empty()) {
+        used -= entries.back().charge;
+        index.erase(entries.back().url);
+        entries.pop_back();
+    }
+}
+
+void PageCache::setDiskDirectory(const std::string& directory) {
+    diskDirectory = directory;
+}
+
+std::string PageCache::diskPath(const std::string& url) const {
+    // FNV-1a; the URL is also stored in the file so collisions are caught
+    uint64_t hash = 1469598103934665603ULL;
+    for (unsigned char c : url) {
+        hash = (hash ^ c) * 1099511628211ULL;
+    }
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash));
+    return diskDirectory + "/" + name;
+}
+
+bool PageCache::loadFromDisk(const std::string& url, std::string& finalURL, std::string& body, time_t& freshUntil) {
+    if (diskDirectory.empty()) return false;
+    std::string path = diskPath(url);
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+
+    std::string magic, storedURL, expiry;
+    if (!std::getline(file, magic) || magic != kDiskMagic) return false;
+    if (!std::getline(file, storedURL) || storedURL != url) return false;
+    if (!std::getline(file, finalURL) || !std::getline(file, expiry)) return false;
+
+    freshUntil = static_cast<time_t>(std::strtoll(expiry.c_str(), nullptr, 10));
+    if (freshUntil <= time(nullptr)) {
+        file.close();
+        std::remove(path.c_str()); // stale, drop it
+        return false;
+    }
+    body.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+void PageCache::storeOnDisk(const std::string& url, const PageSnapshot& snapshot) {
+    if (diskDirectory.empty() || snapshot.freshUntil <= time(nullptr)) return;
+    std::string path = diskPath(url);
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file) return;
+        file << kDiskMagic << "\n" << url << "\n" << snapshot.url << "\n"
+             << static_cast<long long>(snapshot.freshUntil) << "\n";
+        file.write(snapshot.body.data(), snapshot.body.size());
+        if (!file) {
+            file.close();
+            std::remove(temporary.c_str());
+            return;
+        }
+    }
+    std::rename(temporary.c_str(), path.c_str());
+}
+
+time_t PageCache::freshUntil(const HttpResponse& response, time_t now) {
+    std::string control = response.header("cache-control");
+    std::transform(control.begin(), control.end(), control.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    if (control.find("no-store") != std::string::npos || control.find("no-cache") != std::string::npos) {
+        return 0;
+    }
+
+    size_t maxAge = control.find("max-age=");
+    if (maxAge != std::string::npos) {
+        long lifetime = std::atol(control.c_str() + maxAge + 8);
+        long age = std::atol(response.header("age").c_str());
+        return lifetime > age ? now + (lifetime - age) : 0;
+    }
+
+    // Expires is measured against the server's Date to tolerate clock skew
+    time_t expires, served;
+    if (!parseHttpDate(response.header("expires"), expires)) return 0;
+    if (!parseHttpDate(response.header("date"), served)) served = now;
+    return expires > served ? now + (expires - served) : 0;
+}
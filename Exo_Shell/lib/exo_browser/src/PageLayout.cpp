@@ -0,0 +1,114 @@
+#include "../include/PageLayout.h"
+#include <algorithm>
+
+PageLayout::PageLayout(const HTMLParser& document, int width)
+    : document(document), wrapWidth(std::max(width, 1)) {}
+
+void PageLayout::resize(int width) {
+    width = std::max(width, 1);
+    if (width == wrapWidth) return;
+    // Throw the wrapped lines away; they are rebuilt lazily at the new width
+    wrapWidth = width;
+    wrappedUpTo = 0;
+    nextSpan = 0;
+    lines.clear();
+    ranges.clear();
+    spanLines.clear();
+}
+
+bool PageLayout::ensureLines(size_t count) {
+    while (lines.size() < count) {
+        if (!wrapParagraph()) return false;
+    }
+    return true;
+}
+
+bool PageLayout::complete() const {
+    return document.isFinished() && wrappedUpTo >= document.getText().size();
+}
+
+std::string_view PageLayout::lineText(size_t index) const {
+    const LayoutLine& entry = lines[index];
+    return std::string_view(document.getText()).substr(entry.offset, entry.length);
+}
+
+long PageLayout::lineOfSpan(size_t span) {
+    while (spanLines.size() <= span || spanLines[span] < 0) {
+        if (!wrapParagraph()) return -1;
+    }
+    return spanLines[span];
+}
+
+size_t PageLayout::lineAtOffset(size_t offset) {
+    while ((lines.empty() || lines.back().offset + lines.back().length < offset) && wrapParagraph()) {}
+    if (lines.empty()) return 0;
+    auto after = std::upper_bound(lines.begin(), lines.end(), offset,
+                                  [](size_t value, const LayoutLine& entry) { return value < entry.offset; });
+    return after == lines.begin() ? 0 : (after - lines.begin()) - 1;
+}
+
+size_t PageLayout::memoryUsage() const {
+    return sizeof(PageLayout) + lines.capacity() * sizeof(LayoutLine) +
+           ranges.capacity() * sizeof(LinkRange) + spanLines.capacity() * sizeof(long);
+}
+
+// Wraps the next complete paragraph (text up to a '\n'). Greedy: break at
+// the last space that fits, or mid-word if a single word is too long.
+bool PageLayout::wrapParagraph() {
+    const std::string& text = document.getText();
+    size_t end = text.find('\n', wrappedUpTo);
+    if (end == std::string::npos) return false;
+
+    const size_t width = static_cast<size_t>(wrapWidth);
+    size_t lineStart = wrappedUpTo;
+    do {
+        size_t columns = 0;
+        size_t breakAt = std::string::npos;
+        size_t i = lineStart;
+        for (; i < end; ++i) {
+            unsigned char c = text[i];
+            if ((c & 0xC0) == 0x80) continue; // UTF-8 continuation byte
+            if (c == ' ') breakAt = i;
+            if (columns == width) break;
+            ++columns;
+        }
+
+        size_t lineEnd = i;
+        size_t next = i;
+        if (i < end && breakAt != std::string::npos && breakAt > lineStart) {
+            lineEnd = breakAt;
+            next = breakAt + 1;
+        }
+        addLine(lineStart, lineEnd);
+        lineStart = next;
+    } while (lineStart < end);
+
+    wrappedUpTo = end + 1;
+    return true;
+}
+
+void PageLayout::addLine(size_t start, size_t end) {
+    const std::vector<LinkSpan>& spans = document.linkSpans();
+    if (spanLines.size() < spans.size()) spanLines.resize(spans.size(), -1);
+
+    LayoutLine entry{static_cast<uint32_t>(start), static_cast<uint32_t>(end - start),
+                     static_cast<uint32_t>(ranges.size()), 0};
+    // A span still open while streaming has no end yet and is never passed over
+    while (nextSpan < spans.size() && spans[nextSpan].end <= start) ++nextSpan;
+    for (size_t k = nextSpan; k < spans.size() && spans[k].start < end; ++k) {
+        size_t from = std::max(spans[k].start, start);
+        size_t to = std::min(spans[k].end, end);
+        if (spans[k].end == std::string::npos) {
+            // Trimmed like closeAnchor() will, so blank text gets no range
+            const std::string& text = document.getText();
+            while (from < to && text[from] == ' ') ++from;
+            while (to > from && text[to - 1] == ' ') --to;
+        }
+        if (from >= to) continue;
+        if (spanLines[k] < 0) spanLines[k] = static_cast<long>(lines.size());
+        ranges.push_back(LinkRange{static_cast<uint32_t>(from - start), static_cast<uint32_t>(to - from),
+                                   static_cast<uint32_t>(k)});
+        ++entry.rangeCount;
+    }
+    lines.push_back(entry);
+}
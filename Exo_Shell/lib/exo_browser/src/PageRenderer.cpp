@@ -1,18 +1,176 @@
 #include "../include/PageRenderer.h"
+#include "../include/URL.h"
 #include <ncurses.h>  // Ncurses library for terminal control
+#include <algorithm>
+#include <clocale>
 
-PageRenderer::PageRenderer(WebManager& manager) : webManager(manager) {}
-
-void PageRenderer::renderPage(const std::string& content) {
+PageRenderer::PageRenderer(WebManager& manager) : webManager(manager) {
+    setlocale(LC_ALL, "");
     initscr();
-    printw("Rendering Page:\n%s", content.c_str());
-    refresh();
+    cbreak();
+    noecho();
+    keypad(stdscr, TRUE);
+    curs_set(0);
+    idlok(stdscr, TRUE);  // let curses use the terminal's own line scrolling
+    getmaxyx(stdscr, rows, cols);
+    setscrreg(0, viewRows() - 1);
+    shown.assign(viewRows(), -2);
+}
+
+PageRenderer::~PageRenderer() {
+    endwin();
+}
+
+void PageRenderer::renderPage(const std::shared_ptr<PageSnapshot>& newPage, bool restorePosition) {
+    if (!newPage) return;
+    // Remember where we were so going back lands on the same text
+    if (page && layout && topLine < layout->lineCount()) {
+        page->scrollOffset = layout->line(topLine).offset;
+    }
+
+    page = newPage;
+    if (!page->layout) {
+        page->layout = std::make_unique<PageLayout>(*page->document, cols);
+    } else {
+        page->layout->resize(cols);
+    }
+    layout = page->layout.get();
+    topLine = restorePosition ? layout->lineAtOffset(page->scrollOffset) : 0;
+    highlighted = -1;
+    std::fill(shown.begin(), shown.end(), -2);
+    draw();
 }
 
 void PageRenderer::highlightLink(int linkIndex) {
-    // Code to highlight selected link
+    if (!layout || linkIndex < 0 || linkIndex >= linkCount()) return;
+    markSpanDirty(highlighted);
+    highlighted = linkIndex;
+
+    long line = layout->lineOfSpan(linkIndex);
+    long top = static_cast<long>(topLine);
+    if (line >= 0 && (line < top || line >= top + viewRows())) {
+        // Bring the link into view a third of the way down the screen
+        scrollPage(static_cast<int>(std::max(0L, line - viewRows() / 3) - top));
+    }
+    markSpanDirty(highlighted);
+    draw();
 }
 
 void PageRenderer::scrollPage(int lines) {
-    // Code to scroll content
+    if (!layout) return;
+    long target = std::max(0L, static_cast<long>(topLine) + lines);
+
+    // Never scroll past the last screenful
+    size_t screen = static_cast<size_t>(viewRows());
+    if (!layout->ensureLines(target + screen)) {
+        size_t lastTop = layout->lineCount() > screen ? layout->lineCount() - screen : 0;
+        target = std::min(target, static_cast<long>(lastTop));
+    }
+    long delta = target - static_cast<long>(topLine);
+    if (delta == 0) return;
+
+    if (std::abs(delta) < viewRows()) {
+        // Shift what is already on screen; only the exposed rows get drawn
+        scrollok(stdscr, TRUE);
+        wscrl(stdscr, static_cast<int>(delta));
+        scrollok(stdscr, FALSE);
+        if (delta > 0) {
+            std::rotate(shown.begin(), shown.begin() + delta, shown.end());
+            std::fill(shown.end() - delta, shown.end(), -1);
+        } else {
+            std::rotate(shown.rbegin(), shown.rbegin() - delta, shown.rend());
+            std::fill(shown.begin(), shown.begin() - delta, -1);
+        }
+    }
+    topLine = static_cast<size_t>(target);
+    draw();
+}
+
+void PageRenderer::resize() {
+    int oldCols = cols;
+    getmaxyx(stdscr, rows, cols);
+    setscrreg(0, viewRows() - 1);
+    shown.assign(viewRows(), -2);
+    clear();
+
+    if (layout && cols != oldCols) {
+        // Keep the text at the top of the screen in place; the rest of the
+        // page is rewrapped as it scrolls into view
+        size_t anchor = topLine < layout->lineCount() ? layout->line(topLine).offset : 0;
+        layout->resize(cols);
+        topLine = layout->lineAtOffset(anchor);
+    }
+    draw();
+}
+
+void PageRenderer::update() {
+    // Rows that were blank past the end of the text fill in; the rest is untouched
+    draw();
+}
+
+int PageRenderer::linkCount() const {
+    return page ? static_cast<int>(page->document->linkSpans().size()) : 0;
+}
+
+std::string PageRenderer::linkTarget(int linkIndex) const {
+    if (linkIndex < 0 || linkIndex >= linkCount()) return "";
+    const LinkSpan& span = page->document->linkSpans()[linkIndex];
+    return resolveURL(page->url, std::string(page->document->links()[span.link]));
+}
+
+void PageRenderer::draw() {
+    if (!layout) return;
+    for (int row = 0; row < viewRows(); ++row) {
+        size_t line = topLine + row;
+        long wanted = layout->ensureLines(line + 1) ? static_cast<long>(line) : -1;
+        if (shown[row] != wanted) {
+            drawLine(row, wanted);
+            shown[row] = wanted;
+        }
+    }
+
+    // Status bar: URL and position
+    std::string status = " " + page->url + "  line " + std::to_string(topLine + 1);
+    if (page->loading) status += "  loading...";
+    else if (layout->complete()) status += "/" + std::to_string(layout->lineCount());
+    status.resize(cols, ' ');
+    attron(A_REVERSE);
+    mvaddnstr(rows - 1, 0, status.c_str(), cols);
+    attroff(A_REVERSE);
+    refresh();
+}
+
+void PageRenderer::drawLine(int row, long line) {
+    move(row, 0);
+    clrtoeol();
+    if (line < 0) return;
+
+    std::string_view text = layout->lineText(line);
+    const LayoutLine& entry = layout->line(line);
+    size_t position = 0;
+    for (uint32_t i = 0; i < entry.rangeCount; ++i) {
+        const LinkRange& link = layout->range(entry.firstRange + i);
+        addnstr(text.data() + position, link.start - position);
+        int attribute = static_cast<int>(link.span) == highlighted ? A_REVERSE : A_UNDERLINE;
+        attron(attribute);
+        addnstr(text.data() + link.start, link.length);
+        attroff(attribute);
+        position = link.start + link.length;
+    }
+    addnstr(text.data() + position, text.size() - position);
+}
+
+// Marks the rows showing a link so the next draw() repaints them
+void PageRenderer::markSpanDirty(int span) {
+    if (span < 0) return;
+    for (long line = layout->lineOfSpan(span); line >= 0 && static_cast<size_t>(line) < layout->lineCount(); ++line) {
+        const LayoutLine& entry = layout->line(line);
+        bool onLine = false;
+        for (uint32_t i = 0; i < entry.rangeCount; ++i) {
+            if (static_cast<int>(layout->range(entry.firstRange + i).span) == span) onLine = true;
+        }
+        if (!onLine) break;
+        long row = line - static_cast<long>(topLine);
+        if (row >= 0 && row < viewRows()) shown[row] = -2;
+    }
 }
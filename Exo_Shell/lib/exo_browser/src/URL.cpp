@@ -0,0 +1,104 @@
+#include "../include/URL.h"
+#include <algorithm>
+#include <cctype>
+
+bool URL::parse(const std::string& text, URL& out) {
+    out = URL();
+    size_t schemeEnd = text.find("://");
+    if (schemeEnd == std::string::npos) {
+        if (text.empty()) return false;
+        out.scheme = "file";
+        out.path = text;
+        return true;
+    }
+
+    out.scheme = text.substr(0, schemeEnd);
+    std::transform(out.scheme.begin(), out.scheme.end(), out.scheme.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    size_t hostStart = schemeEnd + 3;
+
+    if (out.scheme == "file") {
+        out.path = text.substr(hostStart);
+        return !out.path.empty();
+    }
+    if (out.scheme != "http" && out.scheme != "https") return false;
+
+    size_t pathStart = text.find_first_of("/?#", hostStart);
+    std::string authority = text.substr(hostStart, pathStart - hostStart);
+    out.path = pathStart == std::string::npos ? "/" : text.substr(pathStart);
+    if (out.path[0] != '/') out.path.insert(0, "/");
+    size_t fragment = out.path.find('#');
+    if (fragment != std::string::npos) out.path.erase(fragment);
+
+    out.port = out.scheme == "https" ? 443 : 80;
+    size_t colon = authority.rfind(':');
+    if (colon != std::string::npos && authority.find(']', colon) == std::string::npos) {
+        std::string port = authority.substr(colon + 1);
+        authority.erase(colon);
+        if (port.empty() || !std::all_of(port.begin(), port.end(), ::isdigit) || port.size() > 5) return false;
+        out.port = std::stoi(port);
+    }
+    if (authority.size() > 2 && authority.front() == '[' && authority.back() == ']') {
+        authority = authority.substr(1, authority.size() - 2); // IPv6 literal
+    }
+    out.host = authority;
+    return !out.host.empty();
+}
+
+std::string URL::str() const {
+    if (scheme == "file") return "file://" + path;
+    std::string result = scheme + "://";
+    result += host.find(':') != std::string::npos ? "[" + host + "]" : host;
+    if ((scheme == "http" && port != 80) || (scheme == "https" && port != 443)) {
+        result += ":" + std::to_string(port);
+    }
+    return result + path;
+}
+
+std::string resolveURL(const std::string& base, const std::string& link) {
+    if (link.find("://") != std::string::npos) return link;
+
+    URL url;
+    if (!URL::parse(base, url)) return link;
+
+    std::string target = link.substr(0, link.find('#'));
+    if (target.size() >= 2 && target[0] == '/' && target[1] == '/') {
+        return url.scheme + ":" + target; // scheme-relative
+    }
+    if (target.empty()) return url.str();
+
+    if (target[0] == '/') {
+        url.path = target;
+    } else if (target[0] == '?') {
+        url.path = url.path.substr(0, url.path.find('?')) + target;
+    } else {
+        std::string directory = url.path.substr(0, url.path.find('?'));
+        directory.erase(directory.rfind('/') + 1);
+        url.path = directory + target;
+    }
+
+    // Collapse "." and ".." segments in the path part
+    size_t queryStart = std::min(url.path.find('?'), url.path.size());
+    std::string query = url.path.substr(queryStart);
+    std::string path = url.path.substr(0, queryStart);
+    bool absolute = !path.empty() && path[0] == '/';
+    std::string resolved;
+    size_t start = absolute ? 1 : 0;
+    while (start <= path.size()) {
+        size_t slash = std::min(path.find('/', start), path.size());
+        std::string segment = path.substr(start, slash - start);
+        bool last = slash == path.size();
+        if (segment == "..") {
+            size_t previous = resolved.find_last_of('/', resolved.empty() ? 0 : resolved.size() - 2);
+            resolved.erase(previous == std::string::npos ? 0 : previous + 1);
+            if (last) break;
+        } else if (segment != ".") {
+            resolved += segment;
+            if (!last) resolved += '/';
+        }
+        start = slash + 1;
+    }
+    url.path = (absolute ? "/" : "") + resolved + query;
+    if (url.path.empty()) url.path = "/";
+    return url.str();
+}
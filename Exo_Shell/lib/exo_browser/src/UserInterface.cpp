@@ -1,10 +1,39 @@
 #include "../include/UserInterface.h"
 #include <ncurses.h>
 
-UserInterface::UserInterface(PageRenderer& renderer) : pageRenderer(renderer) {}
+UserInterface::UserInterface(PageRenderer& renderer, WebManager& manager)
+    : pageRenderer(renderer), webManager(manager) {}
 
-void UserInterface::processInput(char command) {
-    if (command == 'j') pageRenderer.scrollPage(1);
-    if (command == 'k') pageRenderer.scrollPage(-1);
-    if (command == 'o') pageRenderer.highlightLink(selectedLinkIndex++);
+void UserInterface::processInput(int command) {
+    int links = pageRenderer.linkCount();
+    switch (command) {
+    case 'j': case KEY_DOWN:  pageRenderer.scrollPage(1); break;
+    case 'k': case KEY_UP:    pageRenderer.scrollPage(-1); break;
+    case ' ': case KEY_NPAGE: pageRenderer.scrollPage(LINES - 2); break;
+    case KEY_PPAGE:           pageRenderer.scrollPage(-(LINES - 2)); break;
+    case 'o': case '\t':
+        // Cycle through the links on the page; the selected one is fetched ahead
+        if (links == 0) break;
+        pageRenderer.highlightLink(selectedLinkIndex = (selectedLinkIndex + 1) % links);
+        webManager.prefetch(pageRenderer.linkTarget(selectedLinkIndex));
+        break;
+    case 'O': case KEY_BTAB:
+        if (links == 0) break;
+        pageRenderer.highlightLink(selectedLinkIndex = (selectedLinkIndex + links - 1) % links);
+        webManager.prefetch(pageRenderer.linkTarget(selectedLinkIndex));
+        break;
+    case '\n': case KEY_ENTER:
+        if (selectedLinkIndex >= 0) show(webManager.fetchPage(pageRenderer.linkTarget(selectedLinkIndex)), false);
+        break;
+    case 'b': show(webManager.goBack(), true); break;
+    case 'f': show(webManager.goForward(), true); break;
+    case 'r': show(webManager.refresh(), true); break;
+    case KEY_RESIZE: pageRenderer.resize(); break;
+    }
+}
+
+void UserInterface::show(const std::shared_ptr<PageSnapshot>& page, bool restorePosition) {
+    if (!page) return; // nothing in that direction
+    selectedLinkIndex = -1;
+    pageRenderer.renderPage(page, restorePosition);
 }
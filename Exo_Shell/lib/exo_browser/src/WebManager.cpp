@@ -1,39 +1,230 @@
 #include "../include/WebManager.h"
-#include <iostream>  // For printing and debugging
+#include <algorithm>
+#include <ctime>
 
-WebManager::WebManager() {}
+namespace {
 
-std::string WebManager::fetchPage(const std::string& url) {
-    // Fetch the page content, add to history
-    std::string htmlContent = "<html>Example HTML content with links</html>";
+const int kMaxPrefetches = 2;             // background fetches in flight at once
+const size_t kPrefetchLinks = 4;          // links queued from each page the user opens
+const size_t kMaxQueuedPrefetches = 16;
+const time_t kPrefetchLifetime = 300;     // seconds a prefetched page may stand in for a fetch
+
+std::shared_ptr<PageSnapshot> makeSnapshot(const std::string& url, std::string body, time_t freshUntil) {
+    auto snapshot = std::make_shared<PageSnapshot>();
+    snapshot->url = url;
+    snapshot->body = std::move(body);
+    snapshot->freshUntil = freshUntil;
+    snapshot->fetchedAt = time(nullptr);
+    snapshot->document = std::make_unique<HTMLParser>();
+    snapshot->document->feed(snapshot->body);
+    snapshot->document->finish();
+    return snapshot;
+}
+
+std::string errorPage(const std::string& message) {
+    std::string escaped;
+    for (char c : message) {
+        if (c == '<') escaped += "&lt;";
+        else if (c == '&') escaped += "&amp;";
+        else escaped += c;
+    }
+    return "<html><body><h1>Error</h1><p>" + escaped + "</p></body></html>";
+}
+
+// Whether a new navigation may show a cached page instead of fetching it
+bool isReusable(const PageSnapshot& page, time_t now) {
+    return page.freshUntil > now || (page.prefetched && now - page.fetchedAt < kPrefetchLifetime);
+}
+
+bool isHttp(const std::string& url) {
+    return url.compare(0, 7, "http://") == 0;
+}
+
+} // namespace
+
+WebManager::WebManager(size_t cacheBudget) : cache(cacheBudget) {}
+
+void WebManager::enableDiskCache(const std::string& directory) {
+    cache.setDiskDirectory(directory);
+}
+
+std::shared_ptr<PageSnapshot> WebManager::fetchPage(const std::string& url) {
+    std::shared_ptr<PageSnapshot> page = load(url, false);
 
     // Push old URL and save new one as current
-    backStack.push(currentURL);
+    if (!currentURL.empty()) backStack.push(currentURL);
     currentURL = url;
-    //history.push_back(url);
-    return htmlContent;
+    forwardStack = std::stack<std::string>();
+    return show(page);
 }
 
-// forward and back through history
-// REQUIRED call refresh() to render the new page
-void WebManager::goBack() {
-    // Logic to go back
+// forward and back through history, restored from the cache when possible
+std::shared_ptr<PageSnapshot> WebManager::goBack() {
+    if (backStack.empty()) return nullptr;
     forwardStack.push(currentURL);
-    currentURL = backStack.pop();
+    currentURL = backStack.top();
+    backStack.pop();
+    return show(load(currentURL, true));
 }
 
-void WebManager::goForward() {
-    // Logic to go forward
+std::shared_ptr<PageSnapshot> WebManager::goForward() {
+    if (forwardStack.empty()) return nullptr;
     backStack.push(currentURL);
-    currentURL = forwardStack.pop()
+    currentURL = forwardStack.top();
+    forwardStack.pop();
+    return show(load(currentURL, true));
 }
 
-// Refresh the page
-std::string refresh(){
-    // fetch content from currentURL
-    std::string htmlContent = "refresh sucess";
-    return htmlContent;
+// Refresh the page, bypassing every cache
+std::shared_ptr<PageSnapshot> WebManager::refresh() {
+    if (currentURL.empty()) return nullptr;
+    auto running = downloads.find(currentURL);
+    if (running != downloads.end()) {
+        http.cancel(running->second.request);
+        if (running->second.prefetch) prefetchesRunning--;
+        downloads.erase(running);
+    }
+    return show(download(currentURL, false));
 }
 
+bool WebManager::poll(int timeoutMs, int wakeFd) {
+    http.run(timeoutMs, wakeFd);
+    bool changed = currentChanged;
+    currentChanged = false;
+    return changed;
+}
+
+void WebManager::prefetch(const std::string& url) {
+    if (!isHttp(url)) return; // local files are read instantly anyway
+    prefetchQueue.erase(std::remove(prefetchQueue.begin(), prefetchQueue.end(), url), prefetchQueue.end());
+    prefetchQueue.push_front(url);
+    if (prefetchQueue.size() > kMaxQueuedPrefetches) prefetchQueue.pop_back();
+    startPrefetches();
+}
 
+std::shared_ptr<PageSnapshot> WebManager::show(std::shared_ptr<PageSnapshot> page) {
+    // Links from the page we are leaving are no longer likely targets
+    prefetchQueue.clear();
+    current = page;
+    if (!page->loading) queueLinkPrefetches(*page);
+    return page;
+}
 
+// History navigation accepts stale snapshots; new navigations only take fresh
+// ones, or a page that was prefetched a moment ago
+std::shared_ptr<PageSnapshot> WebManager::load(const std::string& url, bool allowStale) {
+    time_t now = time(nullptr);
+    std::shared_ptr<PageSnapshot> page = cache.find(url);
+    if (page) {
+        if (allowStale || isReusable(*page, now)) {
+            page->prefetched = false;
+            return page;
+        }
+    }
+
+    std::string finalURL, body;
+    time_t freshUntil;
+    if (cache.loadFromDisk(url, finalURL, body, freshUntil)) {
+        page = makeSnapshot(finalURL, std::move(body), freshUntil);
+        cache.insert(url, page);
+        return page;
+    }
+    return download(url, false);
+}
+
+std::shared_ptr<PageSnapshot> WebManager::download(const std::string& url, bool prefetch) {
+    auto running = downloads.find(url);
+    if (running != downloads.end()) {
+        // Already on its way, most likely as a prefetch the user has now asked for
+        if (!prefetch && running->second.prefetch) {
+            running->second.prefetch = false;
+            running->second.page->prefetched = false;
+            prefetchesRunning--;
+            startPrefetches();
+        }
+        return running->second.page;
+    }
+
+    auto page = std::make_shared<PageSnapshot>();
+    page->url = url;
+    page->document = std::make_unique<HTMLParser>();
+    page->loading = true;
+    page->prefetched = prefetch;
+    page->fetchedAt = time(nullptr);
+
+    // The page stays alive in downloads until the request finishes or is cancelled
+    PageSnapshot* target = page.get();
+    int request = http.fetch(
+        url,
+        [this, target](std::string_view chunk) {
+            target->body.append(chunk.data(), chunk.size());
+            target->document->feed(chunk);
+            if (target == current.get()) currentChanged = true;
+        },
+        [this, url](HttpResponse& response) { finishDownload(url, response); });
+
+    downloads[url] = Download{request, page, prefetch};
+    if (prefetch) prefetchesRunning++;
+    return page;
+}
+
+void WebManager::finishDownload(const std::string& url, HttpResponse& response) {
+    auto found = downloads.find(url);
+    if (found == downloads.end()) return;
+    Download finished = std::move(found->second);
+    downloads.erase(found);
+    if (finished.prefetch) prefetchesRunning--;
+
+    PageSnapshot& page = *finished.page;
+    if (!response.error.empty()) {
+        // Keep whatever arrived; error pages are shown but never cached
+        if (page.body.empty()) page.document->feed(errorPage(response.error));
+        page.document->finish();
+        page.loading = false;
+    } else {
+        page.url = response.url;
+        page.freshUntil = response.status == 200 ? PageCache::freshUntil(response, time(nullptr)) : 0;
+        page.document->finish();
+        page.loading = false;
+        cache.insert(url, finished.page);
+        cache.storeOnDisk(url, page);
+    }
+
+    if (finished.page == current) {
+        currentChanged = true;
+        if (response.error.empty()) queueLinkPrefetches(page);
+    }
+    startPrefetches();
+}
+
+// The first few links of a page are the most likely next stops
+void WebManager::queueLinkPrefetches(const PageSnapshot& page) {
+    size_t queued = 0;
+    for (std::string_view link : page.document->links()) {
+        if (queued == kPrefetchLinks || prefetchQueue.size() >= kMaxQueuedPrefetches) break;
+        std::string target = resolveURL(page.url, std::string(link));
+        if (!isHttp(target) || downloads.count(target) || isCached(target) ||
+            std::find(prefetchQueue.begin(), prefetchQueue.end(), target) != prefetchQueue.end()) {
+            continue;
+        }
+        prefetchQueue.push_back(target);
+        ++queued;
+    }
+    startPrefetches();
+}
+
+void WebManager::startPrefetches() {
+    while (prefetchesRunning < kMaxPrefetches && !prefetchQueue.empty()) {
+        std::string url = prefetchQueue.front();
+        prefetchQueue.pop_front();
+        if (downloads.count(url) || isCached(url)) continue;
+        download(url, true);
+    }
+}
+
+// Prefetching a page that load() would take from the cache is wasted work;
+// a stale copy, though, is only good for history and gets fetched again
+bool WebManager::isCached(const std::string& url) const {
+    std::shared_ptr<PageSnapshot> page = cache.peek(url);
+    return page && isReusable(*page, time(nullptr));
+}
@@ -3,7 +3,7 @@
 #include <fstream>
 #include <string>
 #include <vector>
-#include <map>
+#include "include/exo_options.h"
 
 // Bitwise flags for options
 #define FLAG_n 0x01 // Display line numbers
@@ -65,11 +65,11 @@ void print_line(const std::string& line, int flags) {
 }
 
 uint32_t parseFlags(int argc, char* argv[], std::vector<std::string>& files, std::string& pattern) {
-    std::map<char, int> flag_map = {
+    static constexpr FlagTable flag_table = makeFlagTable({
         {'n', FLAG_n}, {'A', FLAG_A}, {'h', FLAG_h}, {'e', FLAG_e},
         {'s', FLAG_s}, {'T', FLAG_T}, {'b', FLAG_b}, {'v', FLAG_v},
         {'I', FLAG_I}, {'V', FLAG_V}
-    };
+    });
 
 
     uint32_t flags = 0;
@@ -82,8 +82,8 @@ uint32_t parseFlags(int argc, char* argv[], std::vector<std::string>& files, std
         if (arg[0] == '-') {
             for (size_t j = 1; j < arg.size(); ++j) {
                 char flag_char = arg[j];
-                if (flag_map.find(flag_char) != flag_map.end()) {
-                    flags |= flag_map[flag_char];
+                if (uint32_t bit = flag_table[flag_char]) {
+                    flags |= bit;
                 } else {
                     printError("Unknown flag encountered: -", std::to_string(flag_char));
                     errCount++;
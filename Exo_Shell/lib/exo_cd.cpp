@@ -1,17 +1,17 @@
 // exo_cd.cpp
-#include <iostream>
 #include <unistd.h> // for chdir()
+#include "include/exo_output.h"
 
 int main(int argc, char* argv[]) {
     if (argc < 2) {
-        std::cerr << "Usage: cd <directory>" << std::endl;
+        OutputBuffer(STDERR_FILENO).append("Usage: cd <directory>\n").flush();
         return 1;
     }
 
     if (chdir(argv[1]) == 0) {
         return 0; // Successfully changed directory
     } else {
-        std::cerr << "Error: Unable to change directory to " << argv[1] << std::endl;
+        OutputBuffer(STDERR_FILENO).append("Error: Unable to change directory to ").append(argv[1]).append('\n').flush();
         return 1;
     }
 }
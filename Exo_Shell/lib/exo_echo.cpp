@@ -1,10 +1,13 @@
 // exo_echo.cpp
-#include <iostream>
+#include <unistd.h>
+#include "include/exo_output.h"
 
 int main(int argc, char* argv[]) {
+    OutputBuffer out(STDOUT_FILENO);
     for (int i = 1; i < argc; ++i) {
-        std::cout << argv[i] << " ";
+        if (i > 1) out.append(' ');
+        out.append(argv[i]);
     }
-    std::cout << std::endl;
-    return 0;
+    out.append('\n');
+    return out.flush() ? 0 : 1;
 }
@@ -1,7 +1,17 @@
 #include <iostream>
 #include <filesystem>
 #include <string>
-#include <map>
+#include <string_view>
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cctype>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "include/exo_options.h"
 
 #define FLAG_name 0x01
 #define FLAG_type 0x02
@@ -18,11 +28,52 @@
 #define SORT_modified 0x04
 #define SORT_type 0x08
 
+#define DEFAULT_SORT_MEMORY_MB 64
+#define TYPICAL_PATH_BYTES 64 // for splitting the sort budget between records and path bytes
+
 namespace fs = std:: filesystem;
 
+// Sort keys are kept as small fixed-width records; the path bytes they refer
+// to live in one shared buffer instead of a std::string per result
+struct SortKey {
+    int64_t time;  // modified or created time in nanoseconds, depending on the sort flags
+    uint8_t type;  // 0 directory, 1 regular file, 2 symlink, 3 other
+};
+
+struct SortRecord {
+    SortKey key;
+    uint32_t offset;  // into SortState::paths
+    uint32_t length;
+};
+
+struct SortState {
+    uint16_t sort;
+    size_t budget;                     // bytes of records + paths before a run is spilled
+    size_t top;                        // --top N, 0 for a full sort
+    std::vector<SortRecord> records;
+    std::vector<char> paths;
+    std::vector<FILE*> runs;           // sorted runs spilled to temporary files
+    std::vector<std::pair<SortKey, std::string>> heap;  // the best `top` results so far
+};
+
+// One spilled run being merged
+struct RunCursor {
+    FILE* file;
+    SortKey key;
+    std::string path;
+};
+
 // prototypes
 void printError(const std::string& message);
-int parseArgs(int argc, char*  argv[], uint32_t& flags, uint16_t& filter, uint16_t& sort, std::string& path,  std::string& name,  std::string& filter_param);
+int parseArgs(int argc, char*  argv[], uint32_t& flags, uint16_t& filter, uint16_t& sort, std::string& path,  std::string& name,  std::string& filter_param, size_t& top, size_t& memory_mb);
+bool walk(const std::string& root, uint32_t flags, SortState& state);
+SortKey sortKey(const std::string& path, uint16_t sort);
+bool sortLess(uint16_t sort, const SortKey& a, std::string_view path_a, const SortKey& b, std::string_view path_b);
+void sortAdd(SortState& state, const std::string& path, const SortKey& key);
+void sortRecords(SortState& state);
+void spillRun(SortState& state);
+void sortFinish(SortState& state);
+bool readRecord(RunCursor& cursor);
 
 
 int main(int argc, char* argv[]) {
@@ -33,30 +84,267 @@ int main(int argc, char* argv[]) {
 
     uint32_t flags = 0;
     uint16_t filter = 0, sort = 0;
+    size_t top = 0, memory_mb = DEFAULT_SORT_MEMORY_MB;
     std::string path, name, filter_param;
 
-    int parse_result = parseArgs(argc, argv, flags, filter, sort, path, name, filter_param);
+    int parse_result = parseArgs(argc, argv, flags, filter, sort, path, name, filter_param, top, memory_mb);
     if (parse_result != 0) {
         return parse_result;  // Exit if parsing failed
     }
+    if (flags & (FLAG_name | FLAG_type | FLAG_filter)) {
+        std::cerr << "Unsupported flag: -" << (flags & FLAG_name ? 'n' : flags & FLAG_type ? 't' : 'f') << "\n";
+        return -1;
+    }
+    if (path.empty()) path = ".";
+    if (top > 0) flags |= FLAG_sort;  // --top implies sorting, by path unless -s says otherwise
+
+    SortState state;
+    state.sort = sort;
+    state.budget = std::min<size_t>(memory_mb, 2048) * 1024 * 1024;  // record offsets are 32-bit
+    state.top = top;
+    if ((flags & FLAG_sort) && top == 0) {
+        // All the memory a run may take, claimed once; pages are only touched as they fill
+        size_t record_count = state.budget / (sizeof(SortRecord) + TYPICAL_PATH_BYTES);
+        state.records.reserve(record_count);
+        state.paths.reserve(state.budget - record_count * sizeof(SortRecord));
+    }
+
+    bool walked = walk(path, flags, state);
+    if (flags & FLAG_sort) {
+        sortFinish(state);
+    }
+    return walked ? 0 : 1;
+}
+
+// Unsorted results are printed as they are found; sorted ones go through the
+// sort stage. Depth first, one directory_iterator per open directory, so a
+// directory that cannot be read only costs its own subtree. Returns false if
+// any error was reported.
+bool walk(const std::string& root, uint32_t flags, SortState& state) {
+    std::error_code ec;
+    std::vector<fs::directory_iterator> open_dirs;
+    open_dirs.emplace_back(root, ec);
+    if (ec) {
+        printError("Cannot read " + root + ": " + ec.message());
+        return false;
+    }
+
+    bool ok = true;
+    while (!open_dirs.empty()) {
+        fs::directory_iterator& it = open_dirs.back();
+        if (it == fs::directory_iterator()) {
+            open_dirs.pop_back();
+            continue;
+        }
+
+        const std::string& path = it->path().native();
+        if (flags & FLAG_sort) {
+            sortAdd(state, path, sortKey(path, state.sort));
+        } else {
+            std::cout << path << "\r\n";
+        }
+
+        // Symlinks to directories are listed but not followed
+        fs::directory_iterator children;
+        if (it->symlink_status(ec).type() == fs::file_type::directory) {
+            children = fs::directory_iterator(it->path(), ec);
+            if (ec) {
+                printError("Cannot read " + path + ": " + ec.message());
+                ok = false;
+            }
+        }
+
+        it.increment(ec);
+        if (ec) {
+            printError("Error walking " + root + ": " + ec.message());
+            ok = false;
+            open_dirs.pop_back();  // the rest of this directory is lost, its parent carries on
+        }
+        if (children != fs::directory_iterator()) {
+            open_dirs.push_back(std::move(children));
+        }
+    }
+    return ok;
+}
+
+SortKey sortKey(const std::string& path, uint16_t sort) {
+    SortKey key = {0, 0};
+    if (!(sort & (SORT_created | SORT_modified | SORT_type))) {
+        return key;  // sorting by path only, no need to stat
+    }
+    struct stat info;
+    if (lstat(path.c_str(), &info) != 0) {
+        return key;
+    }
+    key.type = S_ISDIR(info.st_mode) ? 0 : S_ISREG(info.st_mode) ? 1 : S_ISLNK(info.st_mode) ? 2 : 3;
+    if (sort & SORT_modified) {
+#if defined(__APPLE__)
+        key.time = info.st_mtimespec.tv_sec * 1000000000LL + info.st_mtimespec.tv_nsec;
+#else
+        key.time = info.st_mtim.tv_sec * 1000000000LL + info.st_mtim.tv_nsec;
+#endif
+    } else if (sort & SORT_created) {
+#if defined(__APPLE__)
+        key.time = info.st_birthtimespec.tv_sec * 1000000000LL + info.st_birthtimespec.tv_nsec;
+#elif defined(STATX_BTIME)
+        struct statx extra;
+        if (statx(AT_FDCWD, path.c_str(), AT_SYMLINK_NOFOLLOW, STATX_BTIME, &extra) == 0 && (extra.stx_mask & STATX_BTIME)) {
+            key.time = extra.stx_btime.tv_sec * 1000000000LL + extra.stx_btime.tv_nsec;
+        } else {
+            key.time = info.st_ctim.tv_sec * 1000000000LL + info.st_ctim.tv_nsec;
+        }
+#else
+        key.time = info.st_ctim.tv_sec * 1000000000LL + info.st_ctim.tv_nsec;  // no birth time here, status change is the closest
+#endif
+    }
+    return key;
+}
+
+// Type first (if asked), then time, then path; -s d flips the whole order
+bool sortLess(uint16_t sort, const SortKey& a, std::string_view path_a, const SortKey& b, std::string_view path_b) {
+    int order;
+    if ((sort & SORT_type) && a.type != b.type) {
+        order = a.type < b.type ? -1 : 1;
+    } else if ((sort & (SORT_created | SORT_modified)) && a.time != b.time) {
+        order = a.time < b.time ? -1 : 1;
+    } else {
+        order = path_a.compare(path_b);
+    }
+    return (sort & SORT_dec) ? order > 0 : order < 0;
+}
+
+void sortAdd(SortState& state, const std::string& path, const SortKey& key) {
+    if (state.top > 0) {
+        // Keep only the best `top` results; the heap's front is the worst of them
+        auto worse = [&](const std::pair<SortKey, std::string>& a, const std::pair<SortKey, std::string>& b) {
+            return sortLess(state.sort, a.first, a.second, b.first, b.second);
+        };
+        if (state.heap.size() < state.top) {
+            state.heap.emplace_back(key, path);
+            std::push_heap(state.heap.begin(), state.heap.end(), worse);
+        } else if (sortLess(state.sort, key, path, state.heap.front().first, state.heap.front().second)) {
+            std::pop_heap(state.heap.begin(), state.heap.end(), worse);
+            state.heap.back().first = key;
+            state.heap.back().second.assign(path);
+            std::push_heap(state.heap.begin(), state.heap.end(), worse);
+        }
+        return;
+    }
+
+    // Both vectors were reserved from the budget, so a run ends when either is full
+    bool full = state.records.size() == state.records.capacity() ||
+                state.paths.capacity() - state.paths.size() < path.size();
+    if (full && !state.records.empty()) {
+        spillRun(state);
+    }
+    state.records.push_back(SortRecord{key, static_cast<uint32_t>(state.paths.size()), static_cast<uint32_t>(path.size())});
+    state.paths.insert(state.paths.end(), path.begin(), path.end());
+}
+
+void sortRecords(SortState& state) {
+    const char* base = state.paths.data();
+    std::sort(state.records.begin(), state.records.end(), [&](const SortRecord& a, const SortRecord& b) {
+        return sortLess(state.sort, a.key, std::string_view(base + a.offset, a.length),
+                        b.key, std::string_view(base + b.offset, b.length));
+    });
+}
 
-    // Debug output (remove or replace with actual functionality)
-    std::cout << "Flags: " << flags << "\n";
-    std::cout << "Filter: " << filter << ", Filter Parameter: " << filter_param << "\n";
-    std::cout << "Sort: " << sort << "\n";
-    std::cout << "Path: " << path << "\n";
+// Sorts what is in memory and writes it out as one run: key, length, path bytes
+void spillRun(SortState& state) {
+    const char* base = state.paths.data();
+    sortRecords(state);
 
-    // Perform actions based on parsed flags, filters, and sort options
-    // For example, if FLAG_sort is set, call sort logic here
+    FILE* run = std::tmpfile();
+    if (run == nullptr) {
+        printError("Cannot create a temporary file for sorting");
+        std::exit(1);
+    }
+    for (const SortRecord& record : state.records) {
+        std::fwrite(&record.key.time, sizeof(record.key.time), 1, run);
+        std::fwrite(&record.key.type, sizeof(record.key.type), 1, run);
+        std::fwrite(&record.length, sizeof(record.length), 1, run);
+        std::fwrite(base + record.offset, 1, record.length, run);
+    }
+    if (std::ferror(run)) {
+        printError("Error writing a temporary file for sorting");
+        std::exit(1);
+    }
+    std::rewind(run);
+    state.runs.push_back(run);
 
-    return 0;
+    // Keep the capacity for the next run
+    state.records.clear();
+    state.paths.clear();
 }
 
-int parseArgs(int argc, char* argv[], uint32_t& flags, uint16_t& filter, uint16_t& sort, std::string& path, std::string& name, std::string& filter_param) {
+bool readRecord(RunCursor& cursor) {
+    uint32_t length;
+    if (std::fread(&cursor.key.time, sizeof(cursor.key.time), 1, cursor.file) != 1 ||
+        std::fread(&cursor.key.type, sizeof(cursor.key.type), 1, cursor.file) != 1 ||
+        std::fread(&length, sizeof(length), 1, cursor.file) != 1) {
+        return false;
+    }
+    cursor.path.resize(length);
+    return std::fread(&cursor.path[0], 1, length, cursor.file) == length;
+}
+
+void sortFinish(SortState& state) {
+    if (state.top > 0) {
+        auto worse = [&](const std::pair<SortKey, std::string>& a, const std::pair<SortKey, std::string>& b) {
+            return sortLess(state.sort, a.first, a.second, b.first, b.second);
+        };
+        std::sort_heap(state.heap.begin(), state.heap.end(), worse);
+        for (const auto& entry : state.heap) {
+            std::cout << entry.second << "\r\n";
+        }
+        return;
+    }
+
+    if (state.runs.empty()) {
+        // Everything fit in memory: sort in place, no temporary files
+        sortRecords(state);
+        for (const SortRecord& record : state.records) {
+            std::cout << std::string_view(state.paths.data() + record.offset, record.length) << "\r\n";
+        }
+        return;
+    }
+    if (!state.records.empty()) {
+        spillRun(state);
+    }
+
+    // k-way merge of the runs, streaming the output as it goes
+    std::vector<RunCursor> cursors;
+    for (FILE* run : state.runs) {
+        RunCursor cursor{run, {0, 0}, ""};
+        if (readRecord(cursor)) {
+            cursors.push_back(std::move(cursor));
+        }
+    }
+    auto after = [&](size_t a, size_t b) {
+        return sortLess(state.sort, cursors[b].key, cursors[b].path, cursors[a].key, cursors[a].path);
+    };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(after)> next(after);
+    for (size_t i = 0; i < cursors.size(); ++i) {
+        next.push(i);
+    }
+    while (!next.empty()) {
+        size_t i = next.top();
+        next.pop();
+        std::cout << cursors[i].path << "\r\n";
+        if (readRecord(cursors[i])) {
+            next.push(i);
+        }
+    }
+    for (FILE* run : state.runs) {
+        std::fclose(run);
+    }
+}
+
+int parseArgs(int argc, char* argv[], uint32_t& flags, uint16_t& filter, uint16_t& sort, std::string& path, std::string& name, std::string& filter_param, size_t& top, size_t& memory_mb) {
     // Flag and option mappings
-    std::map<char, int> flag_map = {{'n', FLAG_name}, {'t', FLAG_type}, {'f', FLAG_filter}, {'s', FLAG_sort}};
-    std::map<char, int> filter_map = {{'e', FILTER_exclude}, {'c', FILTER_created}, {'m', FILTER_modified}, {'t', FILTER_type}};
-    std::map<char, int> sort_map = {{'d', SORT_dec}, {'c', SORT_created}, {'m', SORT_modified}, {'t', SORT_type}};
+    static constexpr FlagTable flag_table = makeFlagTable({{'n', FLAG_name}, {'t', FLAG_type}, {'f', FLAG_filter}, {'s', FLAG_sort}});
+    static constexpr FlagTable filter_table = makeFlagTable({{'e', FILTER_exclude}, {'c', FILTER_created}, {'m', FILTER_modified}, {'t', FILTER_type}});
+    static constexpr FlagTable sort_table = makeFlagTable({{'d', SORT_dec}, {'c', SORT_created}, {'m', SORT_modified}, {'t', SORT_type}});
 
     bool sort_lock = false, filter_lock = false;
     bool sort_check = false, filter_check = false;
@@ -65,12 +353,23 @@ int parseArgs(int argc, char* argv[], uint32_t& flags, uint16_t& filter, uint16_
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
         
-        if (arg[0] == '-') {  // Handling flags
+        if (arg == "--top" || arg == "--mem") {  // Options for the sort stage
+            if (++i >= argc || !std::isdigit(static_cast<unsigned char>(argv[i][0]))) {
+                std::cerr << "Missing number for " << arg << ". Usage: find [--top <count>] [--mem <MiB>] <directory>\n";
+                return -1;
+            }
+            size_t value = std::strtoull(argv[i], nullptr, 10);
+            if (arg == "--top") {
+                top = value;
+            } else {
+                memory_mb = std::max<size_t>(value, 1);
+            }
+        } else if (arg[0] == '-') {  // Handling flags
             for (size_t j = 1; j < arg.size(); ++j) {
                 char flag_char = arg[j];
                 
-                if (flag_map.count(flag_char)) {
-                    flags |= flag_map[flag_char];
+                if (uint32_t bit = flag_table[flag_char]) {
+                    flags |= bit;
                 } else {
                     std::cerr << "Unknown flag: -" << flag_char << "\n";
                     return -1;  // Exit on unknown flag
@@ -99,8 +398,8 @@ int parseArgs(int argc, char* argv[], uint32_t& flags, uint16_t& filter, uint16_
             }
         } else if (filter_check) {  // Handling filter conditions
             for (char filter_char : arg) {
-                if (filter_map.count(filter_char)) {
-                    filter |= filter_map[filter_char];
+                if (uint32_t bit = filter_table[filter_char]) {
+                    filter |= bit;
                 } else {
                     std::cerr << "Unknown filter condition: " << filter_char << "\n";
                 }
@@ -117,8 +416,8 @@ int parseArgs(int argc, char* argv[], uint32_t& flags, uint16_t& filter, uint16_
             filter_check = false;  // Reset after handling
         } else if (sort_check) {  // Handling sort conditions
             for (char sort_char : arg) {
-                if (sort_map.count(sort_char)) {
-                    sort |= sort_map[sort_char];
+                if (uint32_t bit = sort_table[sort_char]) {
+                    sort |= bit;
                 } else {
                     std::cerr << "Unknown sort condition: " << sort_char << "\n";
                 }
@@ -1,8 +1,8 @@
 #include <iostream>
 #include <fstream>
-#include <map>
 #include <string>
 #include <regex>
+#include "include/exo_options.h"
 
 #define FLAG_i 0x01 // case insensitive search
 #define FLAG_v 0x02 // inverse matching
@@ -36,9 +36,9 @@ int main(int argc, char* argv[]) {
 
 int parseArgs(int argc, char*  argv[], uint32_t& flags, std::string& pattern, std::string& file_name){
 
-	std::map<char, int> flag_map = {
+	static constexpr FlagTable flag_table = makeFlagTable({
 		{'i', FLAG_i}, {'v', FLAG_v}, {'c', FLAG_c},
-	};
+	});
 	bool pattern_found = false;
 	std::string arg;
 	for (int i = 1; i < argc; i++){
@@ -46,8 +46,8 @@ int parseArgs(int argc, char*  argv[], uint32_t& flags, std::string& pattern, st
 		if (arg[0] == '-') {
 			for (int ii = 1; ii < arg.size(); ii++){
 				char flag_char = arg[ii];
-				if (flag_map.find(flag_char) != flag_map.end()){
-					flags |= flag_map[flag_char];
+				if (uint32_t bit = flag_table[flag_char]){
+					flags |= bit;
 				} else {
 					std::cerr << "Unknown flag: -" << flag_char << "\r\n";
 				}
@@ -1,14 +1,20 @@
 #include <iostream>
-#include <map>
 #include <string>
 #include <cstdint>
 #include <filesystem>
 #include <iomanip>
 #include <vector>
 #include <algorithm>
+#include <memory>
+#include <string_view>
 #include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
 #include <cstring>
 #include <cstdlib>
+#include "include/exo_options.h"
 
 // Define each flag as a unique bit position
 #define FLAG_L 0x01 // Detailed listing
@@ -26,13 +32,47 @@
 #define FLAG_C 0x1000 // Display in columns
 #define FLAG_1 0x2000 // Force single-column output
 
+#define NAME_BLOCK_SIZE 65536
+
+// Bump allocator for entry names: one allocation per 64 KiB of names
+// instead of a heap path per entry
+struct NameArena {
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* next = nullptr;
+    size_t left = 0;
+
+    const char* store(const char* name, size_t length) {
+        if (length > left) {
+            size_t size = std::max<size_t>(length, NAME_BLOCK_SIZE);
+            blocks.emplace_back(new char[size]);
+            next = blocks.back().get();
+            left = size;
+        }
+        char* copy = next;
+        std::memcpy(copy, name, length);
+        next += length;
+        left -= length;
+        return copy;
+    }
+};
+
+// One listed entry; the name lives in the directory's NameArena
+struct Entry {
+    const char* name;   // NUL-terminated, so it can go straight to the *at() calls
+    uint32_t length;
+    bool is_directory;  // following symlinks, like directory_entry::is_directory()
+    int64_t key;        // modification time (ns) for -t, size for -S
+
+    std::string_view filename() const { return std::string_view(name, length); }
+};
+
 // Function prototypes
 uint32_t parseFlags(int argc, char* argv[], std::string& ignore_pattern);
-void listDirectory(const std::filesystem::path& path, uint32_t flags, const std::string& ignore_pattern);
-void handleFileEntry(const std::filesystem::directory_entry& entry, uint32_t flags, const std::string& ignore_pattern);
+void listDirectory(const std::string& path, uint32_t flags, const std::string& ignore_pattern);
+void handleFileEntry(int dir_fd, const std::string& path, const Entry& entry, uint32_t flags, const std::string& ignore_pattern);
 void printError(const std::string& message);
-void printEntriesInColumns(const std::vector<std::filesystem::directory_entry>& entries, uint32_t flags);
-void printEntriesSingleColumn(const std::vector<std::filesystem::directory_entry>& entries, uint32_t flags);
+void printEntriesInColumns(const std::vector<Entry>& entries, uint32_t flags, size_t max_length);
+void printEntriesSingleColumn(const std::vector<Entry>& entries, uint32_t flags);
 
 int main(int argc, char* argv[]) {
     uint32_t flags = 0;
@@ -55,12 +95,12 @@ int main(int argc, char* argv[]) {
 }
 
 uint32_t parseFlags(int argc, char* argv[], std::string& ignore_pattern) {
-    std::map<char, int> flag_map = {
+    static constexpr FlagTable flag_table = makeFlagTable({
         {'l', FLAG_L}, {'a', FLAG_A}, {'h', FLAG_H}, {'d', FLAG_D},
         {'R', FLAG_R}, {'r', FLAG_r}, {'p', FLAG_P}, {'n', FLAG_N},
         {'m', FLAG_M}, {'I', FLAG_I}, {'t', FLAG_T}, {'S', FLAG_S},
         {'C', FLAG_C}, {'1', FLAG_1}
-    };
+    });
 
     uint32_t flags = 0;
 
@@ -70,8 +110,8 @@ uint32_t parseFlags(int argc, char* argv[], std::string& ignore_pattern) {
         if (arg[0] == '-') {
             for (size_t j = 1; j < arg.size(); ++j) {
                 char flag_char = arg[j];
-                if (flag_map.find(flag_char) != flag_map.end()) {
-                    flags |= flag_map[flag_char];
+                if (uint32_t bit = flag_table[flag_char]) {
+                    flags |= bit;
                 } else {
                     std::cerr << "Unknown flag: -" << flag_char << "\r\n";
                 }
@@ -84,76 +124,108 @@ uint32_t parseFlags(int argc, char* argv[], std::string& ignore_pattern) {
     return flags;
 }
 
-void listDirectory(const std::filesystem::path& path, uint32_t flags, const std::string& ignore_pattern) {
-    std::vector<std::filesystem::directory_entry> entries;
-
-    try {
-        for (const auto& entry : std::filesystem::directory_iterator(path)) {
-            std::string filename = entry.path().filename().string();
-
-            if ((flags & FLAG_I) && filename.find(ignore_pattern) != std::string::npos) {
-                continue; // Skip ignored files
-            }
-
-            if (!(flags & FLAG_A) && filename[0] == '.') {
-                continue; // Skip hidden files unless `-a` is set
-            }
-
-            entries.push_back(entry);
+void listDirectory(const std::string& path, uint32_t flags, const std::string& ignore_pattern) {
+    DIR* dir = opendir(path.c_str());
+    if (dir == nullptr) {
+        printError("Error reading directory: " + path + ": " + std::strerror(errno));
+        return;
+    }
+    int dir_fd = dirfd(dir);
+
+    NameArena names;
+    std::vector<Entry> entries;
+    size_t max_length = 0;  // widest name, for the column layout
+
+    // Entries are read straight from readdir and stat'ed relative to the
+    // directory, so no path is built per entry
+    while (struct dirent* item = readdir(dir)) {
+        const char* filename = item->d_name;
+        if (std::strcmp(filename, ".") == 0 || std::strcmp(filename, "..") == 0) {
+            continue;
         }
 
-        // Sort entries based on the specified flags
-        if (flags & FLAG_T) {
-            std::sort(entries.begin(), entries.end(),
-                      [](const auto& a, const auto& b) {
-                          return std::filesystem::last_write_time(a) > std::filesystem::last_write_time(b);
-                      });
-        } else if (flags & FLAG_S) {
-            std::sort(entries.begin(), entries.end(),
-                      [](const auto& a, const auto& b) {
-                          return a.file_size() > b.file_size(); // Sort by size
-                      });
-        } else {
-            std::sort(entries.begin(), entries.end(),
-                      [](const auto& a, const auto& b) {
-                          return a.path().filename() < b.path().filename();
-                      });
+        if ((flags & FLAG_I) && std::strstr(filename, ignore_pattern.c_str()) != nullptr) {
+            continue; // Skip ignored files
         }
 
-        if (flags & FLAG_r) {
-            std::reverse(entries.begin(), entries.end()); // Reverse order if `-r` is set
+        if (!(flags & FLAG_A) && filename[0] == '.') {
+            continue; // Skip hidden files unless `-a` is set
         }
 
-        // Display directory entries based on the flags
-        if (flags & FLAG_1) {
-            printEntriesSingleColumn(entries, flags);
-        } else if (flags & FLAG_C) {
-            printEntriesInColumns(entries, flags);
-        } else {
-            for (const auto& entry : entries) {
-                handleFileEntry(entry, flags, ignore_pattern);
+        Entry entry;
+        size_t length = std::strlen(filename);
+        entry.name = names.store(filename, length + 1);  // with the NUL
+        entry.length = static_cast<uint32_t>(length);
+        entry.is_directory = item->d_type == DT_DIR;
+        entry.key = 0;
+
+        // Only stat when the type is unknown or a sort key is needed
+        bool need_type = item->d_type == DT_UNKNOWN || item->d_type == DT_LNK;
+        if (need_type || (flags & (FLAG_T | FLAG_S))) {
+            struct stat file_stat;
+            if (fstatat(dir_fd, filename, &file_stat, 0) == 0) {
+                entry.is_directory = S_ISDIR(file_stat.st_mode);
+#if defined(__APPLE__)
+                int64_t modified = file_stat.st_mtimespec.tv_sec * 1000000000LL + file_stat.st_mtimespec.tv_nsec;
+#else
+                int64_t modified = file_stat.st_mtim.tv_sec * 1000000000LL + file_stat.st_mtim.tv_nsec;
+#endif
+                entry.key = (flags & FLAG_T) ? modified : static_cast<int64_t>(file_stat.st_size);
             }
         }
 
-        if (flags & FLAG_M) {
-            std::cout << "\r\n";
+        max_length = std::max(max_length, length);
+        entries.push_back(entry);
+    }
+
+    // Sort entries based on the specified flags
+    if (flags & (FLAG_T | FLAG_S)) {
+        // Newest or largest first
+        std::sort(entries.begin(), entries.end(),
+                  [](const Entry& a, const Entry& b) {
+                      return a.key > b.key;
+                  });
+    } else {
+        std::sort(entries.begin(), entries.end(),
+                  [](const Entry& a, const Entry& b) {
+                      return a.filename() < b.filename();
+                  });
+    }
+
+    if (flags & FLAG_r) {
+        std::reverse(entries.begin(), entries.end()); // Reverse order if `-r` is set
+    }
+
+    // Display directory entries based on the flags
+    if (flags & FLAG_1) {
+        printEntriesSingleColumn(entries, flags);
+    } else if (flags & FLAG_C) {
+        printEntriesInColumns(entries, flags, max_length);
+    } else {
+        for (const auto& entry : entries) {
+            handleFileEntry(dir_fd, path, entry, flags, ignore_pattern);
         }
-    } catch (const std::filesystem::filesystem_error& e) {
-        printError("Error reading directory: " + std::string(e.what()));
     }
+
+    if (flags & FLAG_M) {
+        std::cout << "\r\n";
+    }
+    closedir(dir);
 }
 
-void handleFileEntry(const std::filesystem::directory_entry& entry, uint32_t flags, const std::string& ignore_pattern) {
-    std::string filename = entry.path().filename().string();
+void handleFileEntry(int dir_fd, const std::string& path, const Entry& entry, uint32_t flags, const std::string& ignore_pattern) {
+    std::string_view filename = entry.filename();
 
-    if (flags & FLAG_D && entry.is_directory()) {
+    if (flags & FLAG_D && entry.is_directory) {
         std::cout << filename << "\r"; // Show only directory name with carriage return
         return;
     }
 
     if (flags & FLAG_L) {
-        struct stat file_stat;
-        stat(entry.path().c_str(), &file_stat);
+        struct stat file_stat = {};
+        if (fstatat(dir_fd, entry.name, &file_stat, 0) != 0) {
+            fstatat(dir_fd, entry.name, &file_stat, AT_SYMLINK_NOFOLLOW); // Dangling symlink
+        }
 
         std::cout << ((S_ISDIR(file_stat.st_mode)) ? 'd' : '-') 
                   << ((file_stat.st_mode & S_IRUSR) ? 'r' : '-')
@@ -178,40 +250,32 @@ void handleFileEntry(const std::filesystem::directory_entry& entry, uint32_t fla
         std::cout << filename;
     }
 
-    if ((flags & FLAG_P) && entry.is_directory()) {
+    if ((flags & FLAG_P) && entry.is_directory) {
         std::cout << "/"; // Append '/' if `-p` is set and entry is a directory
     }
 
     std::cout << ((flags & FLAG_M) ? ", " : "\r\n"); // Use carriage return or newline based on `-m` flag
 
     // Recursive listing if `-R` is set and the entry is a directory
-    if (flags & FLAG_R && entry.is_directory()) {
-        std::cout << "\r\n" << entry.path().string() << ":\r\n";
-        listDirectory(entry.path(), flags, ignore_pattern); // Recursively call on subdirectory
+    if (flags & FLAG_R && entry.is_directory) {
+        std::string subdirectory = (std::filesystem::path(path) / filename).string();
+        std::cout << "\r\n" << subdirectory << ":\r\n";
+        listDirectory(subdirectory, flags, ignore_pattern); // Recursively call on subdirectory
     }
 }
 
-// Function to print directory entries in columns
-void printEntriesInColumns(const std::vector<std::filesystem::directory_entry>& entries, uint32_t flags) {
-    const int terminal_width = 80; // Assuming a standard terminal width
-    int max_length = 0;
-
-    // Find the maximum filename length
-    for (const auto& entry : entries) {
-        int length = entry.path().filename().string().length();
-        if (length > max_length) {
-            max_length = length;
-        }
-    }
+// Function to print directory entries in columns; max_length was measured while listing
+void printEntriesInColumns(const std::vector<Entry>& entries, uint32_t flags, size_t max_length) {
+    const size_t terminal_width = 80; // Assuming a standard terminal width
 
     // Adding extra space for better readability
-    max_length += 2; // Add space for padding
+    size_t column_width = max_length + 2; // Add space for padding
 
-    int columns = terminal_width / max_length; // Calculate number of columns
+    size_t columns = std::max<size_t>(terminal_width / column_width, 1); // Calculate number of columns
 
     // Print entries in columns
     for (size_t i = 0; i < entries.size(); ++i) {
-        std::cout << std::left << std::setw(max_length) << entries[i].path().filename().string();
+        std::cout << std::left << std::setw(column_width) << entries[i].filename();
         if ((i + 1) % columns == 0) {
             std::cout << "\r\n"; // New line after reaching the column limit
         }
@@ -223,9 +287,9 @@ void printEntriesInColumns(const std::vector<std::filesystem::directory_entry>&
 
 
 // Function to print directory entries in a single column
-void printEntriesSingleColumn(const std::vector<std::filesystem::directory_entry>& entries, uint32_t flags) {
+void printEntriesSingleColumn(const std::vector<Entry>& entries, uint32_t flags) {
     for (const auto& entry : entries) {
-        std::cout << entry.path().filename().string() << "\r\n"; // Output each entry on a new line
+        std::cout << entry.filename() << "\r\n"; // Output each entry on a new line
     }
 }
 
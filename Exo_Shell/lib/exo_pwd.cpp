@@ -1,15 +1,15 @@
 // exo_pwd.cpp
-#include <iostream>
 #include <unistd.h> // for getcwd()
 #include <limits.h> // for PATH_MAX
+#include "include/exo_output.h"
 
 int main() {
     char cwd[PATH_MAX];
     if (getcwd(cwd, sizeof(cwd)) != nullptr) {
-        std::cout << cwd << std::endl;
+        OutputBuffer out(STDOUT_FILENO);
+        return out.append(cwd).append('\n').flush() ? 0 : 1;
     } else {
-        std::cerr << "Error: Unable to get current directory" << std::endl;
+        OutputBuffer(STDERR_FILENO).append("Error: Unable to get current directory\n").flush();
         return 1;
     }
-    return 0;
 }
@@ -0,0 +1,40 @@
+#ifndef EXO_OPTIONS_H
+#define EXO_OPTIONS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// One single-character flag and the bit it sets
+struct FlagSpec {
+    char name;
+    uint32_t bit;
+};
+
+// Flag character -> bit, 0 for unknown flags. Built at compile time, so
+// parsing a flag is one array load instead of a std::map built per run.
+struct FlagTable {
+    std::array<uint32_t, 128> bits{};
+
+    constexpr uint32_t operator[](char flag) const {
+        unsigned char index = static_cast<unsigned char>(flag);
+        return index < bits.size() ? bits[index] : 0;
+    }
+};
+
+// Usage: static constexpr FlagTable flag_table = makeFlagTable({{'a', FLAG_A}, ...});
+// A repeated flag character or a zero bit fails to compile.
+template <size_t N>
+constexpr FlagTable makeFlagTable(const FlagSpec (&specs)[N]) {
+    FlagTable table{};
+    for (size_t i = 0; i < N; ++i) {
+        unsigned char index = static_cast<unsigned char>(specs[i].name);
+        if (index >= table.bits.size() || specs[i].bit == 0 || table.bits[index] != 0) {
+            throw "invalid or repeated flag in makeFlagTable";
+        }
+        table.bits[index] = specs[i].bit;
+    }
+    return table;
+}
+
+#endif // EXO_OPTIONS_H
@@ -0,0 +1,56 @@
+#ifndef EXO_OUTPUT_H
+#define EXO_OUTPUT_H
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <unistd.h>
+
+// Output for the small tools without iostreams: everything is gathered in
+// a fixed buffer and leaves in a single write(2) unless it overflows.
+// Nothing is written until flush(); there is deliberately no destructor, so
+// a tool using only this (and libc) does not need libstdc++ at all.
+class OutputBuffer {
+public:
+    explicit OutputBuffer(int fd) : fd(fd) {}
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    OutputBuffer& append(const char* data, size_t length) {
+        while (length > 0) {
+            if (used == sizeof(buffer)) flush();
+            size_t count = length < sizeof(buffer) - used ? length : sizeof(buffer) - used;
+            std::memcpy(buffer + used, data, count);
+            used += count;
+            data += count;
+            length -= count;
+        }
+        return *this;
+    }
+
+    OutputBuffer& append(const char* text) { return append(text, std::strlen(text)); }
+    OutputBuffer& append(char c) { return append(&c, 1); }
+
+    // False if the descriptor stopped taking data
+    bool flush() {
+        const char* data = buffer;
+        while (used > 0) {
+            ssize_t written = write(fd, data, used);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                used = 0;
+                return false;
+            }
+            data += written;
+            used -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+private:
+    int fd;
+    size_t used = 0;
+    char buffer[4096];
+};
+
+#endif // EXO_OUTPUT_H
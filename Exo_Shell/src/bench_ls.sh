@@ -0,0 +1,85 @@
+#!/bin/bash
+
+# Peak memory, malloc calls and wall time of exo_ls on a generated directory.
+# Run compile_lib.sh first; the exo_ls in ~/exo_bin is the one measured.
+#
+#   ./bench_ls.sh [entries] [exo_ls flags...]
+#
+# Without flags, exo_ls is run plain and with -l, -t and -S.
+
+ENTRIES="${1:-300000}"
+shift
+EXO_LS="$HOME/exo_bin/exo_ls"
+
+if [ ! -x "$EXO_LS" ]; then
+  echo "No $EXO_LS, run compile_lib.sh first."
+  exit 1
+fi
+
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "$WORK_DIR"' EXIT
+
+# A flat directory of files with realistic name lengths, plus a few subdirectories
+DIR="$WORK_DIR/entries"
+mkdir "$DIR"
+(cd "$DIR" && seq -f "entry_with_a_reasonably_long_name_%07.0f.dat" 0 $((ENTRIES - 1)) | xargs touch)
+for i in 1 2 3 4 5; do
+  mkdir "$DIR/subdirectory_$i"
+done
+echo "Generated $ENTRIES entries in $DIR"
+
+# Preloaded into exo_ls: counts malloc calls and reports them with the peak
+# RSS when the process exits
+cat > "$WORK_DIR/count.c" <<'EOF'
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <stdio.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+static unsigned long calls;
+static void* (*real_malloc)(size_t);
+
+void* malloc(size_t size) {
+    if (!real_malloc) real_malloc = (void* (*)(size_t))dlsym(RTLD_NEXT, "malloc");
+    calls++;
+    return real_malloc(size);
+}
+
+__attribute__((destructor)) static void report(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    long rss_kb = usage.ru_maxrss / 1024;
+#else
+    long rss_kb = usage.ru_maxrss;
+#endif
+    char line[64];
+    int length = snprintf(line, sizeof(line), "%ld %lu\n", rss_kb, calls);
+    write(2, line, length);
+}
+EOF
+if [ "$(uname)" = "Darwin" ]; then
+  cc -O2 -dynamiclib "$WORK_DIR/count.c" -o "$WORK_DIR/count.so" || exit 1
+  export DYLD_FORCE_FLAT_NAMESPACE=1
+  PRELOAD=DYLD_INSERT_LIBRARIES
+else
+  cc -O2 -shared -fPIC "$WORK_DIR/count.c" -o "$WORK_DIR/count.so" -ldl || exit 1
+  PRELOAD=LD_PRELOAD
+fi
+
+if [ $# -gt 0 ]; then
+  RUNS=("$*")
+else
+  RUNS=("" "-l" "-t" "-S")
+fi
+
+printf "%-10s %10s %12s %10s\n" "flags" "wall" "peak RSS" "mallocs"
+for flags in "${RUNS[@]}"; do
+  start=$(date +%s%N)
+  # exo_ls always lists the current directory
+  (cd "$DIR" && env "$PRELOAD=$WORK_DIR/count.so" "$EXO_LS" $flags > /dev/null 2> "$WORK_DIR/report")
+  end=$(date +%s%N)
+  read -r rss_kb calls < <(tail -n 1 "$WORK_DIR/report")
+  printf "%-10s %8d ms %9d KB %10d\n" "${flags:-(none)}" $(((end - start) / 1000000)) "$rss_kb" "$calls"
+done
@@ -0,0 +1,73 @@
+#!/bin/bash
+
+# Startup cost of the tools in ~/exo_bin: each one is spawned many times in a
+# row with posix_spawn and the children's rusage is read afterwards.
+# Run compile_lib.sh first.
+#
+#   ./bench_startup.sh [runs] [tool...]
+#
+# Without tool names, echo, pwd and cd are measured.
+
+RUNS="${1:-2000}"
+shift
+BIN_DIR="$HOME/exo_bin"
+
+if [ $# -gt 0 ]; then
+  TOOLS=("$@")
+else
+  TOOLS=(echo pwd cd)
+fi
+
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "$WORK_DIR"' EXIT
+
+cat > "$WORK_DIR/spawn.c" <<'EOF'
+#include <fcntl.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+
+extern char** environ;
+
+// spawn <runs> <program> [args...]: one line of per-run averages
+int main(int argc, char** argv) {
+    int runs = atoi(argv[1]);
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, 1, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, 2, "/dev/null", O_WRONLY, 0);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < runs; i++) {
+        pid_t pid;
+        if (posix_spawn(&pid, argv[2], &actions, NULL, argv + 2, environ) != 0) {
+            perror(argv[2]);
+            return 1;
+        }
+        waitpid(pid, NULL, 0);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    struct rusage usage;
+    getrusage(RUSAGE_CHILDREN, &usage);
+    double wall_us = ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / 1e3;
+    double cpu_us = (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e6 + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+    printf("%8.1f us %10.1f %12.1f us\n", wall_us / runs, (double)usage.ru_minflt / runs, cpu_us / runs);
+    return 0;
+}
+EOF
+cc -O2 "$WORK_DIR/spawn.c" -o "$WORK_DIR/spawn" || exit 1
+
+printf "%-10s %11s %10s %15s\n" "tool" "wall/run" "faults/run" "user+sys/run"
+for tool in "${TOOLS[@]}"; do
+  program="$BIN_DIR/exo_$tool"
+  if [ ! -x "$program" ]; then
+    echo "No $program, run compile_lib.sh first."
+    continue
+  fi
+  printf "%-10s %s\n" "$tool" "$("$WORK_DIR/spawn" "$RUNS" "$program")"
+done
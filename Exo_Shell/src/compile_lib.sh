@@ -10,6 +10,14 @@ if [ ! -d "$BIN_DIR" ]; then
   echo "Created $BIN_DIR directory."
 fi
 
+# Only link the libraries a tool actually uses, so the small tools that
+# avoid iostreams (echo, pwd, cd) start without loading libstdc++
+if [ "$(uname)" = "Darwin" ]; then
+  LINK_FLAGS="-Wl,-dead_strip_dylibs"
+else
+  LINK_FLAGS="-Wl,--as-needed"
+fi
+
 # Loop through all .cpp files in the lib directory
 for file in "$LIB_DIR"/*.cpp; do
   # Get the base filename without the directory or extension
@@ -17,7 +25,7 @@ for file in "$LIB_DIR"/*.cpp; do
   name="${filename%.*}"
 
   # Compile the C++ file into the ~/exo_bin directory
-  g++ "$file" -std=c++17 -o "$BIN_DIR/$name"
+  g++ "$file" -std=c++17 -O2 $LINK_FLAGS -o "$BIN_DIR/$name"
 
   if [ $? -eq 0 ]; then
     echo "Compiled $file -> $BIN_DIR/$name"
@@ -0,0 +1,348 @@
+use std::io;
+use std::os::unix::io::RawFd;
+use std::os::unix::process::CommandExt;
+use std::path::Path;
+use std::process::Command;
+use std::sync::atomic::{AtomicI32, Ordering};
+use termion::raw::RawTerminal;
+
+const TERMINAL: RawFd = libc::STDIN_FILENO;
+
+// Write end of the self-pipe; the SIGCHLD handler only pokes it and the
+// event loop does the actual reaping
+static SIGCHLD_PIPE: AtomicI32 = AtomicI32::new(-1);
+
+extern "C" fn on_sigchld(_: libc::c_int) {
+    // write() may set errno, which the interrupted code could be about to read
+    let saved = unsafe { *errno_location() };
+    let fd = SIGCHLD_PIPE.load(Ordering::Relaxed);
+    if fd >= 0 {
+        let byte = 1u8;
+        unsafe {
+            libc::write(fd, &byte as *const u8 as *const libc::c_void, 1);
+        }
+    }
+    unsafe {
+        *errno_location() = saved;
+    }
+}
+
+#[cfg(any(target_os = "macos", target_os = "ios", target_os = "freebsd"))]
+unsafe fn errno_location() -> *mut libc::c_int {
+    libc::__error()
+}
+
+#[cfg(not(any(target_os = "macos", target_os = "ios", target_os = "freebsd")))]
+unsafe fn errno_location() -> *mut libc::c_int {
+    libc::__errno_location()
+}
+
+#[derive(Clone, Copy, PartialEq)]
+pub enum JobState {
+    Running,
+    Stopped,
+    Exited(i32),
+    Killed(i32),
+}
+
+struct Job {
+    id: usize,
+    pgid: libc::pid_t,
+    command: String,
+    state: JobState,
+    modes: Option<libc::termios>, // terminal settings the job had when it stopped
+    notify: bool,                 // changed state in the background and not reported yet
+}
+
+/// Every command runs as a job in its own process group. The terminal is
+/// handed to the foreground job, so Ctrl-C and Ctrl-Z only reach it.
+pub struct JobTable {
+    jobs: Vec<Job>,
+    shell_pgid: libc::pid_t,
+    wake_fd: RawFd,
+    interactive: bool,
+}
+
+impl JobTable {
+    pub fn new() -> JobTable {
+        let interactive = unsafe { libc::isatty(TERMINAL) } == 1;
+        let mut fds = [-1; 2];
+        unsafe {
+            if interactive {
+                // Wait until we are in the foreground before taking the terminal
+                while libc::tcgetpgrp(TERMINAL) != libc::getpgrp() {
+                    libc::kill(-libc::getpgrp(), libc::SIGTTIN);
+                }
+                for signal in [libc::SIGINT, libc::SIGQUIT, libc::SIGTSTP, libc::SIGTTIN, libc::SIGTTOU] {
+                    libc::signal(signal, libc::SIG_IGN);
+                }
+                libc::setpgid(0, 0); // fails harmlessly if we already lead a session
+                libc::tcsetpgrp(TERMINAL, libc::getpgrp());
+            }
+
+            if libc::pipe(fds.as_mut_ptr()) == 0 {
+                for fd in fds {
+                    libc::fcntl(fd, libc::F_SETFL, libc::O_NONBLOCK);
+                    libc::fcntl(fd, libc::F_SETFD, libc::FD_CLOEXEC);
+                }
+                SIGCHLD_PIPE.store(fds[1], Ordering::Relaxed);
+            }
+            let mut action: libc::sigaction = std::mem::zeroed();
+            action.sa_sigaction = on_sigchld as extern "C" fn(libc::c_int) as libc::sighandler_t;
+            action.sa_flags = libc::SA_RESTART;
+            libc::sigemptyset(&mut action.sa_mask);
+            libc::sigaction(libc::SIGCHLD, &action, std::ptr::null_mut());
+        }
+
+        JobTable {
+            jobs: Vec::new(),
+            shell_pgid: unsafe { libc::getpgrp() },
+            wake_fd: fds[0],
+            interactive,
+        }
+    }
+
+    /// Blocks until there is terminal input (true) or a child changed state (false)
+    pub fn wait_for_input(&self) -> bool {
+        let mut fds = [
+            libc::pollfd { fd: TERMINAL, events: libc::POLLIN, revents: 0 },
+            libc::pollfd { fd: self.wake_fd, events: libc::POLLIN, revents: 0 },
+        ];
+        loop {
+            let ready = unsafe { libc::poll(fds.as_mut_ptr(), fds.len() as libc::nfds_t, -1) };
+            if ready < 0 && io::Error::last_os_error().kind() == io::ErrorKind::Interrupted {
+                continue;
+            }
+            return ready < 0 || fds[1].revents == 0;
+        }
+    }
+
+    /// Starts a command in its own process group. Foreground jobs are waited
+    /// for and their final state returned; background jobs return at once.
+    pub fn spawn(
+        &mut self,
+        program: &Path,
+        args: &[&str],
+        command_line: &str,
+        background: bool,
+        terminal: &RawTerminal<io::Stdout>,
+    ) -> io::Result<JobState> {
+        let take_terminal = self.interactive && !background;
+        let mut command = Command::new(program);
+        command.args(args);
+        unsafe {
+            command.pre_exec(move || {
+                // Same as the parent does below, whichever runs first wins the race
+                libc::setpgid(0, 0);
+                if take_terminal {
+                    libc::tcsetpgrp(TERMINAL, libc::getpid());
+                }
+                for signal in [libc::SIGINT, libc::SIGQUIT, libc::SIGTSTP, libc::SIGTTIN, libc::SIGTTOU, libc::SIGCHLD] {
+                    libc::signal(signal, libc::SIG_DFL);
+                }
+                Ok(())
+            });
+        }
+
+        // Children start with the terminal's normal (cooked) settings
+        if !background {
+            let _ = terminal.suspend_raw_mode();
+        }
+        let child = match command.spawn() {
+            Ok(child) => child,
+            Err(e) => {
+                let _ = terminal.activate_raw_mode();
+                return Err(e);
+            }
+        };
+
+        let pgid = child.id() as libc::pid_t;
+        unsafe {
+            libc::setpgid(pgid, pgid);
+        }
+        let id = self.jobs.iter().map(|job| job.id).max().unwrap_or(0) + 1;
+        self.jobs.push(Job {
+            id,
+            pgid,
+            command: command_line.to_string(),
+            state: JobState::Running,
+            modes: None,
+            notify: false,
+        });
+
+        if background {
+            print!("[{}] {}\r\n", id, pgid);
+            return Ok(JobState::Running);
+        }
+        Ok(self.wait_foreground(self.jobs.len() - 1, terminal))
+    }
+
+    /// `fg`: continues a job (the most recent one by default) in the foreground
+    pub fn foreground(&mut self, spec: Option<&str>, terminal: &RawTerminal<io::Stdout>) -> Result<JobState, String> {
+        let index = self.find(spec, "fg")?;
+        print!("{}\r\n", self.jobs[index].command);
+        if let Some(modes) = self.jobs[index].modes {
+            unsafe {
+                libc::tcsetattr(TERMINAL, libc::TCSADRAIN, &modes);
+            }
+        } else {
+            let _ = terminal.suspend_raw_mode();
+        }
+        Ok(self.wait_foreground(index, terminal))
+    }
+
+    /// `bg`: lets a stopped job carry on in the background
+    pub fn background(&mut self, spec: Option<&str>) -> Result<String, String> {
+        let index = self.find(spec, "bg")?;
+        let job = &mut self.jobs[index];
+        if job.state == JobState::Stopped {
+            unsafe {
+                libc::kill(-job.pgid, libc::SIGCONT);
+            }
+            job.state = JobState::Running;
+        }
+        Ok(format!("[{}] {} &", job.id, job.command))
+    }
+
+    /// `jobs`: one line per job; finished jobs are dropped once listed
+    pub fn list(&mut self) -> Vec<String> {
+        self.reap();
+        let last = self.jobs.last().map(|job| job.id);
+        let lines = self
+            .jobs
+            .iter()
+            .map(|job| describe(job, Some(job.id) == last))
+            .collect();
+        self.jobs.retain(|job| !is_finished(job.state));
+        lines
+    }
+
+    /// Reaps children and returns what changed in the background since the last call
+    pub fn notifications(&mut self) -> Vec<String> {
+        self.reap();
+        let last = self.jobs.last().map(|job| job.id);
+        let lines = self
+            .jobs
+            .iter_mut()
+            .filter(|job| job.notify)
+            .map(|job| {
+                job.notify = false;
+                describe(job, Some(job.id) == last)
+            })
+            .collect();
+        self.jobs.retain(|job| !is_finished(job.state));
+        lines
+    }
+
+    /// The shell is exiting: hang up on everything still around
+    pub fn hang_up(&mut self) {
+        for job in &self.jobs {
+            unsafe {
+                libc::kill(-job.pgid, libc::SIGHUP);
+                if job.state == JobState::Stopped {
+                    libc::kill(-job.pgid, libc::SIGCONT);
+                }
+            }
+        }
+        self.jobs.clear();
+    }
+
+    fn wait_foreground(&mut self, index: usize, terminal: &RawTerminal<io::Stdout>) -> JobState {
+        let pgid = self.jobs[index].pgid;
+        unsafe {
+            if self.interactive {
+                libc::tcsetpgrp(TERMINAL, pgid);
+            }
+            if self.jobs[index].state == JobState::Stopped {
+                libc::kill(-pgid, libc::SIGCONT);
+                self.jobs[index].state = JobState::Running;
+            }
+        }
+
+        // Same event loop as the prompt, minus the keyboard: background jobs
+        // finishing meanwhile are recorded too
+        loop {
+            self.reap();
+            if self.jobs[index].state != JobState::Running {
+                break;
+            }
+            let mut wake = libc::pollfd { fd: self.wake_fd, events: libc::POLLIN, revents: 0 };
+            unsafe {
+                libc::poll(&mut wake, 1, -1);
+            }
+        }
+
+        if self.interactive {
+            unsafe {
+                let mut modes: libc::termios = std::mem::zeroed();
+                if libc::tcgetattr(TERMINAL, &mut modes) == 0 {
+                    self.jobs[index].modes = Some(modes);
+                }
+                libc::tcsetpgrp(TERMINAL, self.shell_pgid);
+            }
+        }
+        let _ = terminal.activate_raw_mode();
+
+        let state = self.jobs[index].state;
+        if state == JobState::Stopped {
+            self.jobs[index].notify = false;
+            print!("\r\n{}\r\n", describe(&self.jobs[index], true));
+        } else {
+            self.jobs.remove(index);
+        }
+        state
+    }
+
+    fn reap(&mut self) {
+        let mut drain = [0u8; 64];
+        while unsafe { libc::read(self.wake_fd, drain.as_mut_ptr() as *mut libc::c_void, drain.len()) } > 0 {}
+
+        loop {
+            let mut status = 0;
+            let pid = unsafe { libc::waitpid(-1, &mut status, libc::WNOHANG | libc::WUNTRACED | libc::WCONTINUED) };
+            if pid <= 0 {
+                break;
+            }
+            if let Some(job) = self.jobs.iter_mut().find(|job| job.pgid == pid) {
+                job.state = if libc::WIFSTOPPED(status) {
+                    JobState::Stopped
+                } else if libc::WIFCONTINUED(status) {
+                    JobState::Running
+                } else if libc::WIFSIGNALED(status) {
+                    JobState::Killed(libc::WTERMSIG(status))
+                } else {
+                    JobState::Exited(libc::WEXITSTATUS(status))
+                };
+                job.notify = job.state != JobState::Running;
+            }
+        }
+    }
+
+    // "%2", "2" or nothing for the most recent job
+    fn find(&mut self, spec: Option<&str>, builtin: &str) -> Result<usize, String> {
+        self.reap();
+        let found = match spec {
+            None => self.jobs.iter().rposition(|job| !is_finished(job.state)),
+            Some(spec) => {
+                let id = spec.trim_start_matches('%').parse::<usize>().ok();
+                self.jobs.iter().position(|job| Some(job.id) == id && !is_finished(job.state))
+            }
+        };
+        found.ok_or_else(|| format!("{}: {}: no such job", builtin, spec.unwrap_or("current")))
+    }
+}
+
+fn is_finished(state: JobState) -> bool {
+    matches!(state, JobState::Exited(_) | JobState::Killed(_))
+}
+
+fn describe(job: &Job, current: bool) -> String {
+    let state = match job.state {
+        JobState::Running => "Running".to_string(),
+        JobState::Stopped => "Stopped".to_string(),
+        JobState::Exited(0) => "Done".to_string(),
+        JobState::Exited(code) => format!("Exit {}", code),
+        JobState::Killed(signal) => format!("Killed (signal {})", signal),
+    };
+    format!("[{}]{}  {:<20}{}", job.id, if current { "+" } else { " " }, state, job.command)
+}
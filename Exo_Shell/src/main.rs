@@ -1,100 +1,133 @@
-use std::collections::{HashMap, VecDeque};
+mod jobs;
+mod resolver;
+
+use std::collections::VecDeque;
 use std::env;
 use std::fs::{self, OpenOptions, File};
 use std::io::{self, Write, BufRead, BufReader, BufWriter};
-use std::process::Command;
-use termion::event::Event;
+use std::path::PathBuf;
+use termion::event::{self, Event};
 use termion::event::Key;
-use termion::input::TermRead;
 use termion::raw::IntoRawMode;
+use jobs::{JobState, JobTable};
+use resolver::CommandResolver;
 
 const HISTORY_LIMIT: usize = 1000;
 const TRIM_PERCENTAGE: f32 = 0.75;
 
 fn main() {
-    let mut aliases: HashMap<String, String> = HashMap::new();
     let mut history: VecDeque<String> = load_history();
     let mut history_index: isize = -1;
     let home_dir = env::var("HOME").unwrap();
     let history_file_path = format!("{}/exo_bin/.exo_history", home_dir);
 
-    // Set up custom aliases
-    aliases.insert("ls".to_string(), format!("{}/exo_bin/exo_ls", home_dir));
-    aliases.insert("cat".to_string(), format!("{}/exo_bin/exo_cat", home_dir));
-    aliases.insert("echo".to_string(), format!("{}/exo_bin/exo_echo", home_dir));
-    aliases.insert("pwd".to_string(), format!("{}/exo_bin/exo_pwd", home_dir));
+    // Commands come from the exo tools (exo_ls answers to `ls`) and then $PATH
+    let mut resolver = CommandResolver::new(PathBuf::from(format!("{}/exo_bin", home_dir)));
 
-    let stdin = io::stdin();
+    let mut jobs = JobTable::new();
     let mut stdout = io::stdout().into_raw_mode().unwrap();
-    let mut stdin_events = stdin.events();
+    let mut pending: VecDeque<u8> = VecDeque::new(); // typed ahead but not handled yet
 
-    loop {
-        // Display prompt
+    'shell: loop {
+        // Report background jobs that finished or stopped, then display prompt
+        for line in jobs.notifications() {
+            print!("{}\r\n", line);
+        }
         print!("exo-shell$ ");
         stdout.flush().unwrap();
 
-        let mut input = String::new();
+        let input;
         let mut current_input = String::new();
 
-        for evt in stdin_events.by_ref() {
-            match evt.unwrap() {
-                Event::Key(Key::Char('\n')) => {
-                    input = current_input.trim().to_string();
-                    print!("\r\n");
-                    stdout.flush().unwrap();
-
-                    if !input.is_empty() {
-                        save_command(&input, &mut history, &history_file_path);
-                        history_index = -1;
+        // Wait on the keyboard and on child processes at once, so jobs are
+        // reaped (and reported) while the prompt is idle
+        'read: loop {
+            if pending.is_empty() {
+                if !jobs.wait_for_input() {
+                    let lines = jobs.notifications();
+                    if !lines.is_empty() {
+                        print!("\r\x1b[K");
+                        for line in lines {
+                            print!("{}\r\n", line);
+                        }
+                        clear_line(&mut stdout, current_input.clone());
                     }
-                    break; // Break the for loop to process the input
+                    continue;
+                }
+                if !read_input(&mut pending) {
+                    break 'shell; // terminal closed
                 }
-                Event::Key(Key::Char(c)) => {
-                    if c == '\t' {
-                        if let Some(suggestion) = autocomplete(&current_input, &aliases) {
-                            for _ in 0..current_input.len() {
-                                print!("\x08 \x08");
+            }
+
+            while let Some(byte) = pending.pop_front() {
+                let evt = {
+                    let mut rest = std::iter::from_fn(|| pending.pop_front().map(Ok));
+                    match event::parse_event(byte, &mut rest) {
+                        Ok(evt) => evt,
+                        Err(_) => continue,
+                    }
+                };
+                match evt {
+                    Event::Key(Key::Char('\n')) => {
+                        input = current_input.trim().to_string();
+                        print!("\r\n");
+                        stdout.flush().unwrap();
+
+                        if !input.is_empty() {
+                            save_command(&input, &mut history, &history_file_path);
+                            history_index = -1;
+                        }
+                        break 'read; // Stop reading to process the input
+                    }
+                    Event::Key(Key::Char(c)) => {
+                        if c == '\t' {
+                            if let Some(suggestion) = autocomplete(&current_input, &resolver) {
+                                for _ in 0..current_input.len() {
+                                    print!("\x08 \x08");
+                                }
+                                stdout.flush().unwrap();
+                                current_input = suggestion;
+                                print!("{}", current_input);
+                                stdout.flush().unwrap();
                             }
-                            stdout.flush().unwrap();
-                            current_input = suggestion;
-                            print!("{}", current_input);
+                        } else {
+                            current_input.push(c);
+                            print!("{}", c);
                             stdout.flush().unwrap();
                         }
-                    } else {
-                        current_input.push(c);
-                        print!("{}", c);
-                        stdout.flush().unwrap();
                     }
-                }
-                Event::Key(Key::Backspace) => {
-                    if !current_input.is_empty() {
-                        current_input.pop();
-                        print!("\x08 \x08");
-                        stdout.flush().unwrap();
+                    Event::Key(Key::Backspace) => {
+                        if !current_input.is_empty() {
+                            current_input.pop();
+                            print!("\x08 \x08");
+                            stdout.flush().unwrap();
+                        }
                     }
-                }
-                Event::Key(Key::Ctrl('c')) => {
-                    println!("\nExiting...");
-                    return;
-                }
-                Event::Key(Key::Up) => {
-                    if history_index + 1 < history.len() as isize {
-                        history_index += 1;
-                        current_input = history[history_index as usize].clone();
+                    Event::Key(Key::Ctrl('c')) => {
+                        // Only jobs are interrupted; at the prompt it drops the line
+                        current_input.clear();
+                        print!("^C\r\n");
                         clear_line(&mut stdout, current_input.clone());
                     }
-                }
-                Event::Key(Key::Down) => {
-                    if history_index > 0 {
-                        history_index -= 1;
-                        current_input = history[history_index as usize].clone();
-                    } else {
-                        history_index = -1;
-                        current_input.clear();
+                    Event::Key(Key::Up) => {
+                        if history_index + 1 < history.len() as isize {
+                            history_index += 1;
+                            current_input = history[history_index as usize].clone();
+                            clear_line(&mut stdout, current_input.clone());
+                        }
+                    }
+                    Event::Key(Key::Down) => {
+                        if history_index > 0 {
+                            history_index -= 1;
+                            current_input = history[history_index as usize].clone();
+                        } else {
+                            history_index = -1;
+                            current_input.clear();
+                        }
+                        clear_line(&mut stdout, current_input.clone());
                     }
-                    clear_line(&mut stdout, current_input.clone());
+                    _ => {}
                 }
-                _ => {}
             }
         }
 
@@ -103,7 +136,12 @@ fn main() {
             break;
         }
 
-        let parts: Vec<&str> = input.split_whitespace().collect();
+        // A trailing `&` runs the command in the background
+        let (line, background) = match input.strip_suffix('&') {
+            Some(rest) => (rest.trim_end(), true),
+            None => (input.as_str(), false),
+        };
+        let parts: Vec<&str> = line.split_whitespace().collect();
         let command = parts.get(0).unwrap_or(&"");
 
         if *command == "cd" {
@@ -117,17 +155,99 @@ fn main() {
             continue;
         }
 
-        if let Some(program) = aliases.get(*command) {
+        if *command == "jobs" {
+            for line in jobs.list() {
+                print!("{}\r\n", line);
+            }
+            continue;
+        }
+
+        if *command == "fg" {
+            match jobs.foreground(parts.get(1).copied(), &stdout) {
+                Ok(state) => report_exit(state),
+                Err(e) => print!("{}\r\n", e),
+            }
+            continue;
+        }
+
+        if *command == "bg" {
+            match jobs.background(parts.get(1).copied()) {
+                Ok(line) | Err(line) => print!("{}\r\n", line),
+            }
+            continue;
+        }
+
+        if *command == "hash" {
+            match parts.get(1) {
+                Some(&"-r") => resolver.rehash(),
+                Some(_) => {
+                    for name in &parts[1..] {
+                        if resolver.remember(name).is_none() {
+                            print!("hash: {}: not found\r\n", name);
+                        }
+                    }
+                }
+                None => {
+                    let remembered = resolver.remembered();
+                    if remembered.is_empty() {
+                        print!("hash: hash table empty\r\n");
+                    } else {
+                        print!("hits\tcommand\r\n");
+                        for (hits, path) in remembered {
+                            print!("{:4}\t{}\r\n", hits, path.display());
+                        }
+                    }
+                }
+            }
+            continue;
+        }
+
+        if let Some(mut program) = resolver.resolve(command) {
             let args = &parts[1..];
-            match Command::new(program).args(args).status() {
-                Ok(status) if status.success() => (),
-                Ok(_) => eprintln!("Error: Command failed to execute."),
-                Err(e) => eprintln!("Error: Failed to run command '{}'. Reason: {}", program, e),
+            let mut result = jobs.spawn(&program, args, line, background, &stdout);
+            if matches!(&result, Err(e) if e.kind() == io::ErrorKind::NotFound) {
+                // The cached path went away; look the command up again once
+                resolver.forget(command);
+                if let Some(found) = resolver.resolve(command) {
+                    program = found;
+                    result = jobs.spawn(&program, args, line, background, &stdout);
+                }
+            }
+            match result {
+                Ok(state) => report_exit(state),
+                Err(e) => print!("Error: Failed to run command '{}'. Reason: {}\r\n", program.display(), e),
             }
-        } else {
-            eprintln!("Unknown command: {}", command);
+        } else if !command.is_empty() {
+            print!("Unknown command: {}\r\n", command);
         }
     }
+
+    jobs.hang_up();
+}
+
+/// Read whatever the terminal has for us; false once it is closed
+fn read_input(pending: &mut VecDeque<u8>) -> bool {
+    let mut buffer = [0u8; 1024];
+    loop {
+        let count = unsafe { libc::read(libc::STDIN_FILENO, buffer.as_mut_ptr() as *mut libc::c_void, buffer.len()) };
+        if count > 0 {
+            pending.extend(&buffer[..count as usize]);
+            return true;
+        }
+        if count < 0 && io::Error::last_os_error().kind() == io::ErrorKind::Interrupted {
+            continue;
+        }
+        return false;
+    }
+}
+
+fn report_exit(state: JobState) {
+    match state {
+        JobState::Exited(0) | JobState::Running | JobState::Stopped => (),
+        JobState::Killed(signal) if signal == libc::SIGINT => print!("\r\n"),
+        JobState::Killed(signal) => print!("Error: Command killed by signal {}.\r\n", signal),
+        JobState::Exited(_) => print!("Error: Command failed to execute.\r\n"),
+    }
 }
 
 /// Load history from `.exo_history` file in reverse order (newest first)
@@ -180,19 +300,22 @@ fn save_command(command: &str, history: &mut VecDeque<String>, history_file_path
     writeln!(file, "{}", command).unwrap();
 }
 
-fn autocomplete(current_input: &str, aliases: &HashMap<String, String>) -> Option<String> {
-    for alias in aliases.keys() {
-        if alias.starts_with(current_input) {
-            return Some(alias.clone());
+/// Complete the word being typed: a command name from the resolver's index
+/// for the first word, a file in the current directory after that
+fn autocomplete(current_input: &str, resolver: &CommandResolver) -> Option<String> {
+    let (before, word) = match current_input.rfind(' ') {
+        Some(space) => current_input.split_at(space + 1),
+        None => {
+            return resolver.complete(current_input).map(str::to_string);
         }
-    }
+    };
     let current_dir = env::current_dir().unwrap();
     if let Ok(entries) = fs::read_dir(current_dir) {
         for entry in entries.filter_map(Result::ok) {
             let filename = entry.file_name();
             let filename_str = filename.to_string_lossy();
-            if filename_str.starts_with(current_input) {
-                return Some(filename_str.to_string());
+            if filename_str.starts_with(word) {
+                return Some(format!("{}{}", before, filename_str));
             }
         }
     }
@@ -0,0 +1,204 @@
+use std::collections::{HashMap, HashSet};
+use std::env;
+use std::fs;
+use std::os::unix::fs::PermissionsExt;
+use std::path::{Path, PathBuf};
+use std::time::SystemTime;
+
+// The shell's own tools in ~/exo_bin answer to their name without it: exo_ls is `ls`
+const TOOL_PREFIX: &str = "exo_";
+
+struct Directory {
+    path: PathBuf,
+    tools: bool,                   // ~/exo_bin, whose commands win over $PATH
+    modified: Option<SystemTime>,  // mtime when `commands` was read
+    stale: bool,                   // read again on the next refresh whatever the mtime
+    commands: Vec<String>,
+}
+
+struct Entry {
+    path: PathBuf,
+    hits: usize,
+    remembered: bool,  // run or named to `hash`, so `hash` lists it even with no hits
+}
+
+/// Hash table of every executable in ~/exo_bin and on $PATH, in the spirit of
+/// bash's `hash`. A lookup is one hash probe. Directories are only checked
+/// for changes (by mtime) after a miss, and only the changed ones are re-read.
+pub struct CommandResolver {
+    path_var: String,
+    directories: Vec<Directory>,
+    commands: HashMap<String, Entry>,
+    names: Vec<String>,  // sorted, for Tab completion
+}
+
+impl CommandResolver {
+    pub fn new(tools_dir: PathBuf) -> CommandResolver {
+        let path_var = env::var("PATH").unwrap_or_default();
+        let mut resolver = CommandResolver {
+            directories: directories(tools_dir, &path_var),
+            path_var,
+            commands: HashMap::new(),
+            names: Vec::new(),
+        };
+        resolver.rehash();
+        resolver
+    }
+
+    /// Full path for a command, counting the hit for `hash`
+    pub fn resolve(&mut self, name: &str) -> Option<PathBuf> {
+        let path = self.remember(name)?;
+        if let Some(entry) = self.commands.get_mut(name) {
+            entry.hits += 1;
+        }
+        Some(path)
+    }
+
+    /// `hash name`: looks a command up and adds it to the `hash` listing
+    pub fn remember(&mut self, name: &str) -> Option<PathBuf> {
+        let path = self.find(name)?;
+        if let Some(entry) = self.commands.get_mut(name) {
+            entry.remembered = true;
+        }
+        Some(path)
+    }
+
+    /// Full path for a command; names with a slash are used as they are
+    pub fn find(&mut self, name: &str) -> Option<PathBuf> {
+        if name.contains('/') {
+            return Some(PathBuf::from(name));
+        }
+        if env::var("PATH").unwrap_or_default() != self.path_var {
+            let tools_dir = self.directories[0].path.clone();
+            self.path_var = env::var("PATH").unwrap_or_default();
+            self.directories = directories(tools_dir, &self.path_var);
+            self.rehash();
+        } else if !self.commands.contains_key(name) {
+            // Maybe it was installed since the table was built
+            self.refresh();
+        }
+        self.commands.get(name).map(|entry| entry.path.clone())
+    }
+
+    /// Drops a command whose cached path stopped working; its directory is
+    /// re-read on the next lookup
+    pub fn forget(&mut self, name: &str) {
+        if let Some(entry) = self.commands.get(name) {
+            let dir = entry.path.parent().map(Path::to_path_buf);
+            for directory in self.directories.iter_mut() {
+                if Some(&directory.path) == dir.as_ref() {
+                    directory.stale = true;
+                }
+            }
+        }
+        self.commands.remove(name);
+    }
+
+    /// `hash -r`: forget everything and read every directory again
+    pub fn rehash(&mut self) {
+        for directory in self.directories.iter_mut() {
+            directory.stale = true;
+        }
+        self.commands.clear();
+        self.refresh();
+    }
+
+    /// Commands looked up so far, as `hash` lists them: (hits, path)
+    pub fn remembered(&self) -> Vec<(usize, &Path)> {
+        let mut used: Vec<(usize, &Path)> = self
+            .commands
+            .values()
+            .filter(|entry| entry.remembered)
+            .map(|entry| (entry.hits, entry.path.as_path()))
+            .collect();
+        used.sort_by(|a, b| a.1.cmp(b.1));
+        used
+    }
+
+    /// First command name (alphabetically) starting with prefix
+    pub fn complete(&self, prefix: &str) -> Option<&str> {
+        let start = self.names.partition_point(|name| name.as_str() < prefix);
+        self.names
+            .get(start)
+            .filter(|name| name.starts_with(prefix))
+            .map(String::as_str)
+    }
+
+    // Re-reads the directories whose mtime changed
+    fn refresh(&mut self) {
+        let mut changed = false;
+        for directory in self.directories.iter_mut() {
+            let modified = fs::metadata(&directory.path).and_then(|meta| meta.modified()).ok();
+            if !directory.stale && modified == directory.modified {
+                continue;
+            }
+            directory.modified = modified;
+            directory.stale = false;
+            directory.commands = executables(&directory.path, directory.tools);
+            changed = true;
+        }
+        if changed {
+            self.build_table();
+        }
+    }
+
+    // Earlier directories shadow later ones, like a $PATH search would
+    fn build_table(&mut self) {
+        let mut commands: HashMap<String, Entry> = HashMap::new();
+        for directory in &self.directories {
+            for name in &directory.commands {
+                if commands.contains_key(name) {
+                    continue;
+                }
+                let file = if directory.tools { format!("{}{}", TOOL_PREFIX, name) } else { name.clone() };
+                let path = directory.path.join(file);
+                // Keep what `hash` knows about commands that still resolve to the same file
+                let (hits, remembered) = match self.commands.get(name) {
+                    Some(old) if old.path == path => (old.hits, old.remembered),
+                    _ => (0, false),
+                };
+                commands.insert(name.clone(), Entry { path, hits, remembered });
+            }
+        }
+        self.names = commands.keys().cloned().collect();
+        self.names.sort();
+        self.commands = commands;
+    }
+}
+
+fn directories(tools_dir: PathBuf, path_var: &str) -> Vec<Directory> {
+    let mut seen = HashSet::new();
+    let mut directories = vec![Directory { path: tools_dir, tools: true, modified: None, stale: true, commands: Vec::new() }];
+    for dir in path_var.split(':').filter(|dir| !dir.is_empty()) {
+        if seen.insert(dir) {
+            directories.push(Directory { path: PathBuf::from(dir), tools: false, modified: None, stale: true, commands: Vec::new() });
+        }
+    }
+    directories
+}
+
+// Names of the executable files in a directory (tool names without their prefix)
+fn executables(dir: &Path, tools: bool) -> Vec<String> {
+    let mut commands = Vec::new();
+    if let Ok(entries) = fs::read_dir(dir) {
+        for entry in entries.filter_map(Result::ok) {
+            let file_name = entry.file_name();
+            let name = match file_name.to_str() {
+                Some(name) if !tools => name,
+                Some(name) => match name.strip_prefix(TOOL_PREFIX) {
+                    Some(tool) if !tool.is_empty() => tool,
+                    _ => continue,
+                },
+                None => continue,
+            };
+            // Follows symlinks, so linked executables count too
+            let executable = fs::metadata(entry.path())
+                .map(|meta| meta.is_file() && meta.permissions().mode() & 0o111 != 0)
+                .unwrap_or(false);
+            if executable {
+                commands.push(name.to_string());
+            }
+        }
+    }
+    commands
+}